@@ -0,0 +1,484 @@
+// Headless checks of the module's engines. Each check plays boards through two paths that must
+// agree, or through inputs that must be rejected, and counts the cases where they do not:
+// - pieces: the piece pipeline (tracked move and spawn, animator, pieces) against the table
+//   driven board::move, and against grid::generic_move<3> for 3x3 games, on 800k random board and
+//   direction pairs of each size.
+// - grid: grid::generic_move<4> and grid::generic_spawn<4> against board::move and
+//   spawner::spawn on a million random boards.
+// - save: encode, decode and replay of self-played 4x4 and 3x3 games, with keep_playing and scores
+//   past 2^32.
+// - old_saves: version 1 and 2 save fixtures, whole, cut short and with too many moves.
+// - packs: a valid asset pack and malformed variants of it that asset_pack::open must reject.
+//
+//   2048_check [--seed N] [CHECK...]
+// Runs every check, or only the ones named. Prints one line per check on stderr and exits with
+// EXIT_FAILURE when any check fails. Registered with CTest as 2048_check.
+
+#include "animator.hpp"
+#include "asset_pack.hpp"
+#include "board.hpp"
+#include "grid.hpp"
+#include "pieces.hpp"
+#include "replay.hpp"
+#include "rng.hpp"
+#include "save_game.hpp"
+#include "spawner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct options {
+  surge::u64 seed{2048};
+
+  // Names of the checks to run, all of them when empty
+  std::vector<const char *> names{};
+};
+
+struct check_stats {
+  const char *name{nullptr};
+  surge::u64 cases{0};
+  surge::u64 failures{0};
+};
+
+auto parse_options(int argc, char **argv, options &opts) noexcept -> bool {
+  for (int i = 1; i < argc; i++) {
+    const auto arg{argv[i]};
+    const auto has_value{i + 1 < argc};
+
+    if (std::strcmp(arg, "--seed") == 0 && has_value) {
+      opts.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg[0] != '-') {
+      opts.names.push_back(arg);
+    } else {
+      std::fprintf(stderr, "Usage: %s [--seed N] [CHECK...]\n", argv[0]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * A random board of exponents below 8, with about half the slots empty. The AND of two draws
+ * makes equal neighbours, and so merges, common.
+ */
+auto random_board(s2048::rng::generator &gen) noexcept -> s2048::board::board_t {
+  return s2048::rng::next(gen) & s2048::rng::next(gen) & 0x7777777777777777ull;
+}
+
+auto random_direction(s2048::rng::generator &gen) noexcept -> s2048::board::direction {
+  return static_cast<s2048::board::direction>(s2048::rng::next(gen) >> 62);
+}
+
+/*
+ * Plays d and a spawn on b through the tracks the game animates, and checks that the pieces end
+ * on the board and score of the untracked move and spawn. Only the sizes the game shows fit the
+ * pieces, 3x3 boards keeping their 9 slots in the low nibbles of b.
+ */
+template <surge::u8 N>
+auto pieces_agree(s2048::board::board_t b, s2048::board::direction d, s2048::rng::generator gen,
+                  s2048::pieces::pieces_data &pd) noexcept -> bool {
+  using namespace s2048;
+
+  const spawner::config cfg{0.9f};
+
+  auto untracked_gen{gen};
+  const auto expected{grid::move(grid::grid<N>{b}, d)};
+  const auto expected_spawn{grid::spawn(untracked_gen, cfg, expected.board)};
+
+  pieces::from_board(pd, b);
+  animator::animator_data ad{};
+
+  board::track_list tracks{};
+  const auto tracked{grid::move(grid::grid<N>{b}, d, tracks)};
+
+  surge::u64 merged{0};
+  for (surge::u8 t = 0; t < tracks.size; t++) {
+    const auto &track{tracks.tracks[t]};
+    merged += track.kind == board::track_kind::merge ? surge::u64{1} << track.exponent : 0;
+  }
+  const auto moved_tracks{tracks.size};
+
+  const auto spawned{grid::spawn(gen, cfg, tracked.board, tracks)};
+
+  animator::push(ad, tracks);
+  static_cast<void>(animator::update(ad, pd, std::numeric_limits<float>::infinity()));
+
+  return pieces::to_board(pd) == expected_spawn.s && spawned == expected_spawn
+         && tracked.board == expected.board && tracked.score == expected.score
+         && merged == expected.score && tracked.changed == expected.changed
+         && (moved_tracks != 0) == expected.changed && gen.s == untracked_gen.s;
+}
+
+// The board shown by the pieces once the animator has played the tracked move and spawn
+auto check_pieces(surge::u64 seed) noexcept -> check_stats {
+  using namespace s2048;
+
+  constexpr const surge::u64 pairs{800000};
+  check_stats stats{"pieces", 2 * pairs, 0};
+
+  auto gen{rng::stream(seed, 0)};
+  pieces::pieces_data pd{};
+
+  for (surge::u64 i = 0; i < pairs; i++) {
+    const auto b{random_board(gen)};
+    const auto d{random_direction(gen)};
+
+    // The 3x3 board keeps the first 9 slots
+    stats.failures += pieces_agree<4>(b, d, gen, pd) ? 0 : 1;
+    stats.failures += pieces_agree<3>(b & 0xFFFFFFFFFull, d, gen, pd) ? 0 : 1;
+  }
+
+  return stats;
+}
+
+// The generic N x N paths of grid.hpp, run at N = 4, against the 4x4 board and spawner
+auto check_grid(surge::u64 seed) noexcept -> check_stats {
+  using namespace s2048;
+
+  constexpr const surge::u64 boards{1000000};
+  check_stats stats{"grid", boards, 0};
+
+  auto gen{rng::stream(seed, 1)};
+  const spawner::config cfg{0.9f};
+
+  for (surge::u64 i = 0; i < boards; i++) {
+    const auto b{random_board(gen)};
+    const auto d{random_direction(gen)};
+
+    const auto expected{board::move(b, d)};
+    const auto generic{grid::generic_move(grid::grid<4>{b}, d)};
+
+    // Both spawns start from the same generator state, and must leave it in the same state
+    auto spawns{gen};
+    const auto spawned{spawner::spawn(spawns, cfg, b)};
+    const auto generic_spawned{grid::generic_spawn(gen, cfg, grid::grid<4>{b})};
+
+    if (generic.board.s != expected.board || generic.score != expected.score
+        || generic.changed != expected.changed || generic_spawned.s != spawned
+        || gen.s != spawns.s) {
+      stats.failures++;
+    }
+  }
+
+  return stats;
+}
+
+// Plays a game of N x N to its end with the first legal direction in the order drawn from gen
+template <surge::u8 N>
+auto play(s2048::rng::generator &gen, float two_probability) noexcept -> s2048::save_game::save {
+  using namespace s2048;
+
+  save_game::save s{};
+  s.size = N;
+  s.two_probability = two_probability;
+  s.start_rng = rng::stream(rng::next(gen), 0);
+
+  const spawner::config cfg{s.two_probability};
+
+  auto spawns{s.start_rng};
+  auto b{grid::spawn(spawns, cfg, grid::spawn(spawns, cfg, grid::grid<N>{}))};
+
+  while (grid::legal_moves(b) != 0) {
+    const auto legal{grid::legal_moves(b)};
+
+    auto d{random_direction(gen)};
+    while ((legal & board::move_bit(d)) == 0) {
+      d = static_cast<board::direction>((d + 1) % 4);
+    }
+
+    const auto moved{grid::move(b, d)};
+    s.score += moved.score;
+    b = grid::spawn(spawns, cfg, moved.board);
+    save_game::record_move(s, d);
+  }
+
+  s.board = b.s;
+  s.rng = spawns;
+  return s;
+}
+
+auto same_save(const s2048::save_game::save &a, const s2048::save_game::save &b) noexcept
+    -> bool {
+  return a.board == b.board && a.size == b.size && a.score == b.score
+         && a.best_score == b.best_score
+         && std::memcmp(&a.two_probability, &b.two_probability, sizeof(float)) == 0
+         && a.keep_playing == b.keep_playing && a.rng.s == b.rng.s
+         && a.start_rng.s == b.start_rng.s && a.move_count == b.move_count && a.moves == b.moves;
+}
+
+auto check_save(surge::u64 seed) noexcept -> check_stats {
+  using namespace s2048;
+
+  constexpr const surge::u64 games{200};
+  check_stats stats{"save", games, 0};
+
+  auto gen{rng::stream(seed, 2)};
+  std::vector<surge::u8> bytes{};
+
+  for (surge::u64 i = 0; i < games; i++) {
+    const auto two_probability{i % 2 == 0 ? 0.9f : 0.5f};
+    auto s{i % 5 == 0 ? play<3>(gen, two_probability) : play<4>(gen, two_probability)};
+    s.keep_playing = i % 3 == 0;
+
+    // Best scores past 2^32 must survive the round trip
+    s.best_score = s.score + (i % 4 == 0 ? surge::u64{1} << 40 : 0);
+
+    save_game::encode(s, bytes);
+
+    save_game::save decoded{};
+    const auto ok{save_game::decode(bytes.data(), bytes.size(), decoded)};
+    const auto replayed{replay::run(decoded)};
+
+    // A truncated history must be rejected rather than read past the end
+    save_game::save rejected{};
+    const auto truncated{
+        s.move_count != 0 && save_game::decode(bytes.data(), bytes.size() - 1, rejected)};
+
+    // So must a size the game does not play, and a full 4x4 board read as 3x3
+    auto resized{bytes};
+    const auto resize{[&](surge::u32 size) {
+      std::memcpy(resized.data() + offsetof(save_game::header, size), &size, sizeof(size));
+      return save_game::decode(resized.data(), resized.size(), rejected);
+    }};
+    const auto wrong_size{resize(5) || (s.size == 4 && resize(3))};
+
+    if (!ok || !same_save(s, decoded) || !replayed.matches || replayed.moves != s.move_count
+        || truncated || wrong_size) {
+      stats.failures++;
+    }
+  }
+
+  return stats;
+}
+
+// A version 1 save: board 0x0000123000210001, score 1234, best 56789, three moves
+constexpr const std::array<surge::u8, 41> save_v1{
+    0x53, 0x32, 0x53, 0x56, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x21, 0x00,
+    0x30, 0x12, 0x00, 0x00, 0xd2, 0x04, 0x00, 0x00, 0xd5, 0xdd, 0x00, 0x00,
+    0xef, 0xbe, 0xad, 0xde, 0x78, 0x56, 0x34, 0x12, 0x03, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x27};
+
+// A version 2 save: board 0x0000000003211000, score 2048, best 4096, two probability 0.9,
+// generators {1, 2, 3, 4} and {5, 6, 7, 8}, moves up, down, left, right, down, up
+constexpr const std::array<surge::u8, 98> save_v2{
+    0x53, 0x32, 0x53, 0x56, 0x02, 0x00, 0x00, 0x00, 0x00, 0x10, 0x21, 0x03,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x66, 0x66, 0x66, 0x3f, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xe4, 0x01};
+
+// Offset of the move count in the headers of both versions
+constexpr const surge::usize v1_move_count_offset{32};
+constexpr const surge::usize v2_move_count_offset{24};
+
+/*
+ * Saves of the earlier versions must keep decoding: both keep their board and scores, version 2
+ * its whole game, and version 1 drops its history. Cut or inconsistent files must be rejected.
+ */
+auto check_old_saves(surge::u64) noexcept -> check_stats {
+  using namespace s2048;
+
+  check_stats stats{"old_saves", 0, 0};
+
+  const auto expect{[&](bool passed) {
+    stats.cases++;
+    stats.failures += passed ? 0 : 1;
+  }};
+
+  // Decodes bytes after setting their move count, when it is not 0
+  const auto decode{[](auto bytes, surge::usize size, surge::usize count_offset, surge::u32 count,
+                       save_game::save &s) {
+    if (count != 0) {
+      std::memcpy(bytes.data() + count_offset, &count, sizeof(count));
+    }
+    return save_game::decode(bytes.data(), size, s);
+  }};
+
+  save_game::save s{};
+
+  expect(decode(save_v1, save_v1.size(), v1_move_count_offset, 0, s)
+         && s.board == 0x0000123000210001ull && s.score == 1234 && s.best_score == 56789
+         && s.move_count == 0 && s.moves.empty() && !s.keep_playing
+         && s.rng.s == rng::from_seed(0xdeadbeef).s && s.start_rng.s == s.rng.s);
+  expect(!decode(save_v1, save_v1.size() - 2, v1_move_count_offset, 0, s));
+  expect(!decode(save_v1, save_v1.size() - 1, v1_move_count_offset, 0, s));
+  expect(!decode(save_v1, save_v1.size(), v1_move_count_offset, 5, s));
+
+  const std::array<surge::u64, 4> rng_now{1, 2, 3, 4};
+  const std::array<surge::u64, 4> rng_start{5, 6, 7, 8};
+  const std::array<board::direction, 6> moves{board::up,    board::down, board::left,
+                                              board::right, board::down, board::up};
+
+  const auto same_moves{[&](const save_game::save &d) {
+    for (surge::u32 i = 0; i < d.move_count; i++) {
+      if (save_game::recorded_move(d, i) != moves[i]) {
+        return false;
+      }
+    }
+    return d.move_count == moves.size();
+  }};
+
+  expect(decode(save_v2, save_v2.size(), v2_move_count_offset, 0, s)
+         && s.board == 0x0000000003211000ull && s.score == 2048 && s.best_score == 4096
+         && std::fabs(s.two_probability - 0.9f) < 1e-6f && !s.keep_playing && s.rng.s == rng_now
+         && s.start_rng.s == rng_start && same_moves(s));
+  expect(!decode(save_v2, save_v2.size() - 3, v2_move_count_offset, 0, s));
+  expect(!decode(save_v2, save_v2.size() - 1, v2_move_count_offset, 0, s));
+  expect(!decode(save_v2, save_v2.size(), v2_move_count_offset, 9, s));
+  expect(!decode(save_v2, save_v2.size(), v2_move_count_offset, 0xFFFFFFFF, s));
+
+  return stats;
+}
+
+// Writes bytes to path and opens them as an asset pack
+auto open_pack(const std::vector<std::byte> &bytes, const std::string &path) noexcept -> bool {
+  using namespace s2048;
+
+  const auto out{std::fopen(path.c_str(), "wb")};
+  if (out == nullptr) {
+    return false;
+  }
+
+  const auto written{std::fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size()};
+  if (std::fclose(out) != 0 || !written) {
+    return false;
+  }
+
+  asset_pack::pack p{};
+  const auto ok{asset_pack::open(p, path.c_str())
+                && asset_pack::find(p, "resources/pieces_2.png") != nullptr};
+  asset_pack::close(p);
+  return ok;
+}
+
+/*
+ * A valid pack of one 2x2 texture opens, and every malformed variant of it is rejected,
+ * including entries whose offset, size or dimensions would wrap the bounds checks around
+ */
+auto check_packs(surge::u64) noexcept -> check_stats {
+  using namespace s2048;
+
+  check_stats stats{"packs", 0, 0};
+
+  std::error_code ec{};
+  const auto path{(std::filesystem::temp_directory_path(ec) / "2048_check.pack").string()};
+
+  constexpr const surge::u64 data_offset{128};
+
+  asset_pack::header h{asset_pack::magic, asset_pack::version, 1, 0};
+  asset_pack::entry e{{}, 2, 2, data_offset, 16};
+  std::strncpy(e.name.data(), "resources/pieces_2.png", e.name.size() - 1);
+
+  // Bakes the pack after letting edit change its header and entry
+  const auto expect{[&](bool opens, auto &&edit) {
+    auto eh{h};
+    auto ee{e};
+    edit(eh, ee);
+
+    std::vector<std::byte> bytes(data_offset + 16, std::byte{0x7F});
+    std::memcpy(bytes.data(), &eh, sizeof(eh));
+    std::memcpy(bytes.data() + sizeof(eh), &ee, sizeof(ee));
+
+    stats.cases++;
+    stats.failures += open_pack(bytes, path) == opens ? 0 : 1;
+  }};
+
+  using header_t = asset_pack::header;
+  using entry_t = asset_pack::entry;
+
+  expect(true, [](header_t &, entry_t &) {});
+  expect(false, [](header_t &eh, entry_t &) { eh.magic[0] = 'X'; });
+  expect(false, [](header_t &eh, entry_t &) { eh.version++; });
+  expect(false, [](header_t &eh, entry_t &) { eh.entry_count = 2; });
+  expect(false, [](header_t &eh, entry_t &) { eh.entry_count = 0xFFFFFFFF; });
+  expect(false, [](header_t &, entry_t &ee) { ee.name.back() = 'x'; });
+  expect(false, [](header_t &, entry_t &ee) { ee.offset = 64; });
+  expect(false, [](header_t &, entry_t &ee) { ee.offset = data_offset + 1; });
+  expect(false, [](header_t &, entry_t &ee) { ee.offset = data_offset + 64; });
+  expect(false, [](header_t &, entry_t &ee) { ee.offset = 0xFFFFFFFFFFFFFFC0ull; });
+  expect(false, [](header_t &, entry_t &ee) { ee.size = 20; });
+  expect(false, [](header_t &, entry_t &ee) {
+    ee.width = 4;
+    ee.size = 32;
+  });
+  expect(false, [](header_t &, entry_t &ee) {
+    // 2^31 x 2^31 x 4 wraps to 0 in 64 bits
+    ee.width = 0x80000000u;
+    ee.height = 0x80000000u;
+    ee.size = 0;
+  });
+  expect(false, [](header_t &, entry_t &ee) {
+    ee.width = 0;
+    ee.height = 0;
+    ee.size = 0;
+    ee.offset = 0xFFFFFFFFFFFFFFC0ull;
+  });
+
+  std::filesystem::remove(path, ec);
+  return stats;
+}
+
+struct check {
+  const char *name;
+  auto (*run)(surge::u64 seed) noexcept -> check_stats;
+};
+
+auto named(const char *name, const std::vector<const char *> &names) noexcept -> bool {
+  return std::ranges::any_of(names, [&](const char *n) { return std::strcmp(n, name) == 0; });
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  using namespace s2048;
+
+  options opts{};
+  if (!parse_options(argc, argv, opts)) {
+    return EXIT_FAILURE;
+  }
+
+  const std::array checks{check{"pieces", check_pieces}, check{"grid", check_grid},
+                          check{"save", check_save}, check{"old_saves", check_old_saves},
+                          check{"packs", check_packs}};
+
+  for (const auto name : opts.names) {
+    const auto is_check{[&](const check &c) { return std::strcmp(c.name, name) == 0; }};
+    if (std::ranges::none_of(checks, is_check)) {
+      std::fprintf(stderr, "Unknown check %s\n", name);
+      return EXIT_FAILURE;
+    }
+  }
+
+  board::init();
+
+  bool passed{true};
+  for (const auto &c : checks) {
+    if (!opts.names.empty() && !named(c.name, opts.names)) {
+      continue;
+    }
+
+    const auto r{c.run(opts.seed)};
+    std::fprintf(stderr, "%-12s %10llu cases %8llu failures\n", r.name,
+                 static_cast<unsigned long long>(r.cases),
+                 static_cast<unsigned long long>(r.failures));
+    passed = passed && r.failures == 0;
+  }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,364 @@
+// Microbenchmarks for the board, pieces and animator kernels. Every kernel runs over a corpus of
+// packed boards sampled from self-play (bench/boards.txt, whose header says how it was made and
+// how to replace it). Reports ns/op and heap allocations per op as a table on stderr and as JSON
+// on stdout (or --json FILE).
+//
+// The sprite layer is not covered since committing it needs a live sprite database, and so a GL
+// context.
+
+#include "animator.hpp"
+#include "board.hpp"
+#include "grid.hpp"
+#include "pieces.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Allocations are counted through the global operator new
+surge::u64 allocation_count{0}; // NOLINT
+
+struct options {
+  const char *corpus{SURGE_MODULE_2048_BENCH_CORPUS};
+  const char *json{nullptr};
+  surge::u32 rounds{20};
+};
+
+struct kernel_stats {
+  const char *name{nullptr};
+  surge::u64 ops{0};
+  double ns_per_op{0.0};
+  double allocs_per_op{0.0};
+};
+
+auto parse_options(int argc, char **argv, options &opts) noexcept -> bool {
+  for (int i = 1; i < argc; i++) {
+    const auto arg{argv[i]};
+    const auto has_value{i + 1 < argc};
+
+    if (std::strcmp(arg, "--corpus") == 0 && has_value) {
+      opts.corpus = argv[++i];
+    } else if (std::strcmp(arg, "--json") == 0 && has_value) {
+      opts.json = argv[++i];
+    } else if (std::strcmp(arg, "--rounds") == 0 && has_value) {
+      opts.rounds = static_cast<surge::u32>(std::strtoul(argv[++i], nullptr, 10));
+    } else {
+      std::fprintf(stderr, "Usage: %s [--corpus FILE] [--json FILE] [--rounds N]\n", argv[0]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+auto load_corpus(const char *path) noexcept -> std::vector<s2048::board::board_t> {
+  std::vector<s2048::board::board_t> corpus{};
+
+  auto file{std::fopen(path, "r")};
+  if (file == nullptr) {
+    return corpus;
+  }
+
+  std::array<char, 256> line{};
+  while (std::fgets(line.data(), static_cast<int>(line.size()), file) != nullptr) {
+    if (line[0] == '#' || line[0] == '\n') {
+      continue;
+    }
+    corpus.push_back(std::strtoull(line.data(), nullptr, 16));
+  }
+
+  std::fclose(file);
+  return corpus;
+}
+
+auto clock_overhead() noexcept -> double {
+  using clock = std::chrono::steady_clock;
+
+  constexpr const surge::u32 samples{100000};
+  std::chrono::nanoseconds total{0};
+
+  for (surge::u32 i = 0; i < samples; i++) {
+    const auto t0{clock::now()};
+    const auto t1{clock::now()};
+    total += t1 - t0;
+  }
+
+  return static_cast<double>(total.count()) / samples;
+}
+
+/*
+ * Calls setup(b) untimed for every board of the corpus and, if it returns true, times op(b).
+ * op returns how many kernel invocations it performed.
+ */
+template <typename Setup, typename Op>
+auto run(const char *name, const std::vector<s2048::board::board_t> &corpus, surge::u32 rounds,
+         double overhead, Setup &&setup, Op &&op) noexcept -> kernel_stats {
+  using clock = std::chrono::steady_clock;
+
+  kernel_stats stats{name, 0, 0.0, 0.0};
+
+  double ns{0.0};
+  surge::u64 allocations{0};
+  surge::u64 samples{0};
+
+  for (surge::u32 r = 0; r < rounds; r++) {
+    for (const auto b : corpus) {
+      if (!setup(b)) {
+        continue;
+      }
+
+      const auto a0{allocation_count};
+      const auto t0{clock::now()};
+      const auto ops{op(b)};
+      const auto t1{clock::now()};
+      const auto a1{allocation_count};
+
+      ns += static_cast<double>((t1 - t0).count());
+      allocations += a1 - a0;
+      stats.ops += ops;
+      samples++;
+    }
+  }
+
+  if (stats.ops != 0) {
+    const auto ops{static_cast<double>(stats.ops)};
+    stats.ns_per_op = (ns - overhead * static_cast<double>(samples)) / ops;
+    stats.allocs_per_op = static_cast<double>(allocations) / ops;
+  }
+
+  return stats;
+}
+
+// One logic step of the game
+constexpr const float logic_step{1.0f / 120.0f};
+
+// An N x N board holding the exponents of a corpus board, repeated over the slots past the 16th
+template <surge::u8 N> auto to_grid(s2048::board::board_t b) noexcept -> s2048::grid::grid<N> {
+  s2048::grid::grid<N> g{};
+  for (surge::u8 slot = 0; slot < s2048::grid::grid<N>::slots; slot++) {
+    s2048::grid::set(g, slot, static_cast<surge::u8>((b >> (4 * (slot % 16))) & 0xF));
+  }
+  return g;
+}
+
+// Times the four moves of grid<N>, on boards made from the corpus by to_grid
+template <surge::u8 N>
+auto run_grid(const char *name, const std::vector<s2048::board::board_t> &corpus,
+              surge::u32 rounds, double overhead, surge::u32 &score) noexcept -> kernel_stats {
+  using namespace s2048;
+
+  grid::grid<N> g{};
+
+  const auto convert{[&](board::board_t b) {
+    g = to_grid<N>(b);
+    return true;
+  }};
+
+  return run(name, corpus, rounds, overhead, convert, [&](board::board_t) {
+    for (const auto d : {board::direction::up, board::direction::down, board::direction::left,
+                         board::direction::right}) {
+      const auto result{grid::move(g, d)};
+      score += static_cast<surge::u32>(result.score) + (result.changed ? 1u : 0u);
+    }
+    return surge::u64{4};
+  });
+}
+
+} // namespace
+
+auto operator new(std::size_t size) -> void * {
+  allocation_count++;
+  if (auto p{std::malloc(size == 0 ? 1 : size)}) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+auto operator new[](std::size_t size) -> void * {
+  return ::operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+auto main(int argc, char **argv) -> int {
+  using namespace s2048;
+
+  options opts{};
+  if (!parse_options(argc, argv, opts)) {
+    return EXIT_FAILURE;
+  }
+
+  const auto corpus{load_corpus(opts.corpus)};
+  if (corpus.empty()) {
+    std::fprintf(stderr, "Unable to load any board from %s\n", opts.corpus);
+    return EXIT_FAILURE;
+  }
+
+  board::init();
+
+  const auto overhead{clock_overhead()};
+  const auto rounds{opts.rounds};
+
+  pieces::pieces_data pd{};
+  animator::animator_data ad{};
+  surge::u32 score{0};
+
+  const auto fresh{[&](board::board_t b) {
+    pieces::from_board(pd, b);
+    ad = animator::animator_data{};
+    return true;
+  }};
+
+  // Queues the tracks of a right move, which most corpus positions allow
+  const auto queued{[&](board::board_t b) {
+    fresh(b);
+    board::track_list tracks{};
+    static_cast<void>(board::move(b, board::direction::right, tracks));
+    animator::push(ad, tracks);
+    return true;
+  }};
+
+  std::vector<kernel_stats> results{};
+
+  struct direction_kernels {
+    const char *move_name;
+    const char *tracks_name;
+    board::direction d;
+  };
+
+  const std::array<direction_kernels, 4> directions{
+      direction_kernels{"board::move(up)", "board::move+tracks(up)", board::direction::up},
+      direction_kernels{"board::move(down)", "board::move+tracks(down)", board::direction::down},
+      direction_kernels{"board::move(left)", "board::move+tracks(left)", board::direction::left},
+      direction_kernels{"board::move(right)", "board::move+tracks(right)",
+                        board::direction::right}};
+
+  const auto any{[](board::board_t) { return true; }};
+
+  for (const auto &k : directions) {
+    results.push_back(run(k.tracks_name, corpus, rounds, overhead, any, [&](board::board_t b) {
+      board::track_list tracks{};
+      const auto result{board::move(b, k.d, tracks)};
+      score += result.score + tracks.size;
+      return surge::u64{1};
+    }));
+  }
+
+  // Starts, plays and ends a whole move
+  results.push_back(run("animator::update", corpus, rounds, overhead, queued, [&](board::board_t) {
+    static_cast<void>(animator::update(ad, pd, std::numeric_limits<float>::infinity()));
+    return surge::u64{1};
+  }));
+
+  const auto moving{[&](board::board_t b) {
+    queued(b);
+    static_cast<void>(animator::update(ad, pd, 0.0f));
+    return true;
+  }};
+
+  results.push_back(run("idle", corpus, rounds, overhead, moving, [&](board::board_t) {
+    static_cast<void>(pieces::idle(pd));
+    return surge::u64{1};
+  }));
+
+  results.push_back(run("update_positions", corpus, rounds, overhead, moving, [&](board::board_t) {
+    pieces::update_positions(pd, logic_step);
+    return surge::u64{1};
+  }));
+
+  // Only positions where the game goes on, the case checked on every idle frame
+  const auto playing{[&](board::board_t b) {
+    if (board::max_exponent(b) >= pieces::win_exponent) {
+      return false;
+    }
+
+    return board::legal_moves(b) != 0 && fresh(b);
+  }};
+
+  results.push_back(run("game_over", corpus, rounds, overhead, playing, [&](board::board_t b) {
+    score += pieces::game_over(b, board::legal_moves(b), false) == nullptr ? 1u : 0u;
+    return surge::u64{1};
+  }));
+
+  results.push_back(run("board::legal_moves", corpus, rounds, overhead, any,
+                        [&](board::board_t b) {
+                          score += board::legal_moves(b);
+                          return surge::u64{1};
+                        }));
+
+  for (const auto &k : directions) {
+    results.push_back(run(k.move_name, corpus, rounds, overhead, any, [&](board::board_t b) {
+      const auto result{board::move(b, k.d)};
+      score += result.score;
+      return surge::u64{1};
+    }));
+  }
+
+  // The 4x4 grid goes through the board tables, the other sizes through the generic line loops
+  results.push_back(run_grid<3>("grid<3>::move", corpus, rounds, overhead, score));
+  results.push_back(run_grid<4>("grid<4>::move", corpus, rounds, overhead, score));
+  results.push_back(run_grid<5>("grid<5>::move", corpus, rounds, overhead, score));
+  results.push_back(run_grid<6>("grid<6>::move", corpus, rounds, overhead, score));
+  results.push_back(run_grid<7>("grid<7>::move", corpus, rounds, overhead, score));
+  results.push_back(run_grid<8>("grid<8>::move", corpus, rounds, overhead, score));
+
+  // Report. The checksum is printed so the kernel results stay observable and are not optimized out
+  std::fprintf(stderr, "%-26s %12s %12s %14s\n", "kernel", "ops", "ns/op", "allocs/op");
+  for (const auto &r : results) {
+    std::fprintf(stderr, "%-26s %12llu %12.1f %14.3f\n", r.name,
+                 static_cast<unsigned long long>(r.ops), r.ns_per_op, r.allocs_per_op);
+  }
+
+  auto out{stdout};
+  if (opts.json != nullptr) {
+    out = std::fopen(opts.json, "w");
+    if (out == nullptr) {
+      std::fprintf(stderr, "Unable to open %s\n", opts.json);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::fprintf(out, "{\n  \"corpus\": \"%s\",\n  \"positions\": %llu,\n  \"rounds\": %u,\n",
+               opts.corpus, static_cast<unsigned long long>(corpus.size()), rounds);
+  std::fprintf(out, "  \"clock_overhead_ns\": %.1f,\n  \"checksum\": %u,\n", overhead, score);
+  std::fprintf(out, "  \"kernels\": [\n");
+
+  for (surge::usize i = 0; i < results.size(); i++) {
+    const auto &r{results[i]};
+    std::fprintf(out,
+                 "    {\"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.2f, "
+                 "\"allocs_per_op\": %.4f}%s\n",
+                 r.name, static_cast<unsigned long long>(r.ops), r.ns_per_op, r.allocs_per_op,
+                 i + 1 < results.size() ? "," : "");
+  }
+
+  std::fprintf(out, "  ]\n}\n");
+
+  if (out != stdout) {
+    std::fclose(out);
+  }
+
+  return EXIT_SUCCESS;
+}
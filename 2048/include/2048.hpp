@@ -1,6 +1,8 @@
 #ifndef SURGE_MODULE_2048_HPP
 #define SURGE_MODULE_2048_HPP
 
+#include "board.hpp"
+
 #include "sc_container_types.hpp"
 #include "sc_integer_types.hpp"
 #include "sc_options.hpp"
@@ -18,27 +20,7 @@
 
 namespace s2048 {
 
-using state_code_t = surge::u8;
-enum game_state : state_code_t {
-  idle,
-  compress_up,
-  compress_down,
-  compress_left,
-  compress_right,
-  merge_up,
-  merge_down,
-  merge_left,
-  merge_right,
-  piece_removal,
-  add_piece,
-  check_game_over
-};
-
-#ifdef SURGE_BUILD_TYPE_Debug
-auto state_to_str(game_state s) -> const char *;
-#endif
-
-using state_queue = surge::deque<game_state>;
+using input_queue = surge::deque<board::direction>;
 
 void new_game();
 
@@ -0,0 +1,17 @@
+#ifndef SURGE_MODULE_2048_ALLOC_COUNTER_HPP
+#define SURGE_MODULE_2048_ALLOC_COUNTER_HPP
+
+#include "sc_integer_types.hpp"
+
+namespace s2048::alloc_counter {
+
+/*
+ * Debug builds replace the global operator new of the module with one that counts calls before
+ * forwarding to malloc. The module is built with hidden visibility, so only allocations made by
+ * its own code (on any of its threads) are counted, not those of the engine.
+ */
+auto allocations() noexcept -> surge::u64;
+
+} // namespace s2048::alloc_counter
+
+#endif // SURGE_MODULE_2048_ALLOC_COUNTER_HPP
@@ -0,0 +1,36 @@
+#ifndef SURGE_MODULE_2048_ANIMATOR_HPP
+#define SURGE_MODULE_2048_ANIMATOR_HPP
+
+#include "board.hpp"
+#include "pieces.hpp"
+
+namespace s2048::animator {
+
+/*
+ * Plays the tracks of the moves resolved on the logical board over the pieces. Track lists play
+ * one after the other. While more than one is waiting, the one playing is fast-forwarded, so the
+ * pieces never lag more than a move behind the board.
+ */
+struct animator_data {
+  surge::deque<board::track_list> pending{};
+
+  // The front list has been started on the pieces
+  bool playing{false};
+
+  // Pieces consumed by the merges of the playing list, removed when its slides end
+  pieces::piece_id_queue_t stale_pieces{};
+};
+
+void push(animator_data &ad, const board::track_list &tracks) noexcept;
+
+auto idle(const animator_data &ad) noexcept -> bool;
+
+/*
+ * Plays dt seconds of animation. Returns true when the last pending list ends during the call,
+ * at which point the pieces show the logical board.
+ */
+auto update(animator_data &ad, pieces::pieces_data &pd, float dt) noexcept -> bool;
+
+} // namespace s2048::animator
+
+#endif // SURGE_MODULE_2048_ANIMATOR_HPP
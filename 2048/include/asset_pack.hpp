@@ -0,0 +1,64 @@
+#ifndef SURGE_MODULE_2048_ASSET_PACK_HPP
+#define SURGE_MODULE_2048_ASSET_PACK_HPP
+
+#include "mapped_file.hpp"
+#include "sc_integer_types.hpp"
+
+#include <array>
+#include <cstddef>
+
+namespace s2048::asset_pack {
+
+/*
+ * Module assets baked into a single file by the 2048_pack tool. The file starts with a header,
+ * followed by the table of contents, followed by the pixel data of every texture. Textures are
+ * stored decoded as RGBA8 rows, top row first, each starting on a data_alignment boundary, so
+ * they can be uploaded straight from a mapping of the file.
+ */
+constexpr const std::array<char, 4> magic{'S', '2', 'P', 'K'};
+constexpr const surge::u32 version{1};
+constexpr const surge::u64 data_alignment{64};
+
+struct header {
+  std::array<char, 4> magic;
+  surge::u32 version;
+  surge::u32 entry_count;
+  surge::u32 reserved;
+};
+
+struct entry {
+  // Path the asset was baked from, as looked up by the game (e.g. resources/board.png)
+  std::array<char, 56> name;
+  surge::u32 width;
+  surge::u32 height;
+  surge::u64 offset;
+  surge::u64 size;
+};
+
+static_assert(sizeof(header) == 16);
+static_assert(sizeof(entry) == 80);
+
+// A read only mapping of a pack file
+struct pack {
+  mapped_file::mapping file{};
+  const entry *entries{nullptr};
+  surge::u32 entry_count{0};
+};
+
+/*
+ * Maps the pack at path and validates its header and table of contents. Returns false, leaving p
+ * closed, when the file is missing or malformed.
+ */
+auto open(pack &p, const char *path) noexcept -> bool;
+void close(pack &p) noexcept;
+
+// nullptr when the pack has no asset with this name
+auto find(const pack &p, const char *name) noexcept -> const entry *;
+
+inline auto pixels(const pack &p, const entry &e) noexcept -> const std::byte * {
+  return p.file.data + e.offset;
+}
+
+} // namespace s2048::asset_pack
+
+#endif // SURGE_MODULE_2048_ASSET_PACK_HPP
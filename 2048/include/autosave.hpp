@@ -0,0 +1,43 @@
+#ifndef SURGE_MODULE_2048_AUTOSAVE_HPP
+#define SURGE_MODULE_2048_AUTOSAVE_HPP
+
+#include "save_game.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace s2048::autosave {
+
+/*
+ * Writes save_game snapshots on a background thread. The game fills the back buffer and submits
+ * it; the writer swaps it with the front buffer under a lock and writes the front one, so the
+ * game thread only ever pays for the copy of a snapshot. Snapshots submitted while a write is in
+ * flight replace each other, only the latest one is written.
+ */
+struct autosaver {
+  std::string path{};
+
+  std::array<save_game::save, 2> buffers{};
+  surge::u8 back{0};
+
+  std::mutex lock{};
+  std::condition_variable wake{};
+  bool pending{false};
+  bool stopping{false};
+
+  std::thread writer{};
+};
+
+void start(autosaver &as, const char *path);
+
+// Copies s into the back buffer and wakes the writer
+void submit(autosaver &as, const save_game::save &s);
+
+// Writes the last submitted snapshot, if any is pending, and joins the writer
+void stop(autosaver &as);
+
+} // namespace s2048::autosave
+
+#endif // SURGE_MODULE_2048_AUTOSAVE_HPP
@@ -0,0 +1,122 @@
+#ifndef SURGE_MODULE_2048_BOARD_HPP
+#define SURGE_MODULE_2048_BOARD_HPP
+
+#include "sc_integer_types.hpp"
+
+#include <array>
+
+namespace s2048::board {
+
+/*
+ * A packed 4x4 board. The tile at slot s = 4 * row + col is stored as its exponent
+ * (value = 2^exponent, 0 means empty) in the nibble starting at bit 4 * s.
+ */
+using board_t = surge::u64;
+using row_t = surge::u16;
+
+enum direction : surge::u8 { up, down, left, right };
+
+constexpr auto move_bit(direction d) noexcept -> surge::u8 {
+  return static_cast<surge::u8>(1u << d);
+}
+
+/*
+ * Slot of the k-th cell of line i on a board of side x side slots, counting from the wall the
+ * tiles move towards in d. The sized boards of grid.hpp share it.
+ */
+constexpr auto line_slot(direction d, surge::u8 i, surge::u8 k, surge::u8 side = 4) noexcept
+    -> surge::u8 {
+  switch (d) {
+  case direction::up:
+    return static_cast<surge::u8>(side * k + i);
+  case direction::down:
+    return static_cast<surge::u8>(side * (side - 1 - k) + i);
+  case direction::left:
+    return static_cast<surge::u8>(side * i + k);
+  case direction::right:
+  default:
+    return static_cast<surge::u8>(side * i + side - 1 - k);
+  }
+}
+
+struct move_result {
+  board_t board;
+  surge::u32 score;
+  bool changed;
+};
+
+/*
+ * Animation tracks of a move, for front ends that show it. A slide carries the tile at from to
+ * to. A merge does the same, then fuses the tile with the one that ends at to into a tile of the
+ * given exponent. A spawn creates a tile of the given exponent at to once the other tracks end.
+ * Tiles that stay in place have no track.
+ */
+enum class track_kind : surge::u8 { slide, merge, spawn };
+
+struct track {
+  track_kind kind;
+  surge::u8 from;
+  surge::u8 to;
+  surge::u8 exponent;
+};
+
+// At most one track per tile, plus the spawn that follows the move
+struct track_list {
+  std::array<track, 17> tracks{};
+  surge::u8 size{0};
+};
+
+/*
+ * Builds the row move tables. Calling this is optional, the tables are built on first use, but
+ * doing it at load time keeps the ~2 MB build out of the first move.
+ */
+void init() noexcept;
+
+auto get_exponent(board_t b, surge::u8 slot) noexcept -> surge::u8;
+auto set_exponent(board_t b, surge::u8 slot, surge::u8 exponent) noexcept -> board_t;
+
+auto transpose(board_t b) noexcept -> board_t;
+
+/*
+ * Bit s of the mask is set when slot s is empty
+ */
+auto empty_mask(board_t b) noexcept -> surge::u16;
+
+/*
+ * Slot of the n-th (0 based) set bit of mask, in constant time. n must be smaller than the
+ * popcount of the mask. Spawning on the n-th empty slot, for a uniformly drawn n, is then
+ * select_slot(empty_mask(b), n).
+ */
+auto select_slot(surge::u16 mask, surge::u8 n) noexcept -> surge::u8;
+
+auto move(board_t b, direction d) noexcept -> move_result;
+
+/*
+ * Same as move(b, d), also appending the tracks of the move. Slower than the table driven move,
+ * it is meant for the move being shown, not for searches.
+ */
+auto move(board_t b, direction d, track_list &tracks) noexcept -> move_result;
+
+/*
+ * Appends the tracks of moving in d a board of side x side slots packed like board_t, with slot
+ * s = side * row + col in the nibble at bit 4 * s. Sides go up to 4, the 3x3 game of grid.hpp
+ * being the other one packed this way.
+ */
+void append_tracks(board_t b, direction d, surge::u8 side, track_list &tracks) noexcept;
+
+/*
+ * Puts a tile on an empty slot and appends its spawn track
+ */
+auto spawn(board_t b, surge::u8 slot, surge::u8 exponent, track_list &tracks) noexcept -> board_t;
+
+auto max_exponent(board_t b) noexcept -> surge::u8;
+
+/*
+ * Mask of the moves that change the board, with move_bit(d) set for each legal direction d. The
+ * game is over when it is 0.
+ */
+auto legal_moves(board_t b) noexcept -> surge::u8;
+
+} // namespace s2048::board
+
+#endif // SURGE_MODULE_2048_BOARD_HPP
@@ -2,14 +2,22 @@
 #define SURGE_MODULE_2048_DEBUG_WINDOW_HPP
 
 #include "2048.hpp"
+#include "animator.hpp"
+#include "metrics.hpp"
 #include "pieces.hpp"
 #include "type_aliases.hpp"
 
 namespace s2048::debug_window {
 
+// Sizes the GPU side buffers were created with, shown against what the game puts in them
+struct capacities {
+  surge::u32 sprites;
+  surge::u32 glyphs;
+};
+
 void draw(surge::window::window_t w, bool &show, const tdb_t &tdb, const sdb_t &sdb,
-          const pieces::pieces_data &pd, const pieces::piece_id_queue_t &spc,
-          const state_queue &stq) noexcept;
+          const pieces::pieces_data &pd, const animator::animator_data &ad,
+          const metrics::recorder &mr, const capacities &caps) noexcept;
 
 } // namespace s2048::debug_window
 
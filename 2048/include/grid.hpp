@@ -0,0 +1,233 @@
+#ifndef SURGE_MODULE_2048_GRID_HPP
+#define SURGE_MODULE_2048_GRID_HPP
+
+#include "board.hpp"
+#include "spawner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <type_traits>
+
+namespace s2048::grid {
+
+/*
+ * Boards of N x N slots, with the same rules as the 4x4 board. The slot s = N * row + col holds
+ * an exponent (value = 2^exponent, 0 means empty). The storage follows the size:
+ * 3x3 and 4x4  - nibbles of a u64. 4x4 is the packed board_t itself and uses its move tables.
+ * 5x5          - nibbles of a 128 bit pair of u64, the first 16 slots in lo.
+ * 6x6 to 8x8   - one byte per slot. 36 nibbles would not fit 128 bits, and per slot the line
+ *                loops below cost about the same on bytes as on the nibbles of 5x5 (see the
+ *                grid<N>::move kernels of bench/pieces_bench.cpp).
+ */
+struct u128 {
+  surge::u64 lo{0};
+  surge::u64 hi{0};
+
+  friend constexpr auto operator==(const u128 &, const u128 &) noexcept -> bool = default;
+};
+
+template <surge::u8 N>
+using storage_t = std::conditional_t<
+    (N <= 4), surge::u64, std::conditional_t<(N == 5), u128, std::array<surge::u8, N * N>>>;
+
+template <surge::u8 N> struct grid {
+  static_assert(N >= 3 && N <= 8, "Boards go from 3x3 to 8x8");
+
+  static constexpr const surge::u8 size{N};
+  static constexpr const surge::u8 slots{N * N};
+
+  // Nibbles saturate at 2^15, like the 4x4 board. Bytes stop where a merge still fits the score.
+  static constexpr const surge::u8 max_exponent{N <= 5 ? 15 : 31};
+
+  storage_t<N> s{};
+
+  friend constexpr auto operator==(const grid &, const grid &) noexcept -> bool = default;
+};
+
+template <surge::u8 N> struct move_result {
+  grid<N> board;
+  surge::u64 score;
+  bool changed;
+};
+
+template <surge::u8 N> constexpr auto get(const grid<N> &g, surge::u8 slot) noexcept -> surge::u8 {
+  if constexpr (N <= 4) {
+    return static_cast<surge::u8>((g.s >> (4 * slot)) & 0xF);
+  } else if constexpr (N == 5) {
+    const auto word{slot < 16 ? g.s.lo : g.s.hi};
+    return static_cast<surge::u8>((word >> (4 * (slot & 15))) & 0xF);
+  } else {
+    return g.s[slot];
+  }
+}
+
+template <surge::u8 N> constexpr void set(grid<N> &g, surge::u8 slot, surge::u8 exponent) noexcept {
+  if constexpr (N <= 4) {
+    const auto shift{4 * slot};
+    g.s = (g.s & ~(surge::u64{0xF} << shift)) | (surge::u64{exponent & 0xFu} << shift);
+  } else if constexpr (N == 5) {
+    auto &word{slot < 16 ? g.s.lo : g.s.hi};
+    const auto shift{4 * (slot & 15)};
+    word = (word & ~(surge::u64{0xF} << shift)) | (surge::u64{exponent & 0xFu} << shift);
+  } else {
+    g.s[slot] = exponent;
+  }
+}
+
+// Bit s of the mask is set when slot s is empty
+template <surge::u8 N> auto empty_mask(const grid<N> &g) noexcept -> surge::u64 {
+  if constexpr (N == 4) {
+    return board::empty_mask(g.s);
+  } else {
+    surge::u64 mask{0};
+    for (surge::u8 slot = 0; slot < grid<N>::slots; slot++) {
+      mask |= get(g, slot) == 0 ? surge::u64{1} << slot : 0;
+    }
+    return mask;
+  }
+}
+
+template <surge::u8 N> auto max_exponent(const grid<N> &g) noexcept -> surge::u8 {
+  if constexpr (N == 4) {
+    return board::max_exponent(g.s);
+  } else {
+    surge::u8 e{0};
+    for (surge::u8 slot = 0; slot < grid<N>::slots; slot++) {
+      e = std::max(e, get(g, slot));
+    }
+    return e;
+  }
+}
+
+/*
+ * Same rule as the 4x4 board: each line is compressed towards the wall, then only the first pair
+ * of equal tiles counting from the wall merges. move below uses the board tables for 4x4 instead,
+ * and 2048_check compares the two.
+ */
+template <surge::u8 N>
+auto generic_move(const grid<N> &g, board::direction d) noexcept -> move_result<N> {
+  move_result<N> result{grid<N>{}, 0, false};
+
+  for (surge::u8 i = 0; i < N; i++) {
+    std::array<surge::u8, N> cells{};
+    surge::u8 count{0};
+
+    for (surge::u8 k = 0; k < N; k++) {
+      const auto e{get(g, board::line_slot(d, i, k, N))};
+      if (e != 0) {
+        cells[count] = e;
+        count++;
+      }
+    }
+
+    for (surge::u8 k = 0; k + 1 < count; k++) {
+      if (cells[k] == cells[k + 1] && cells[k] < grid<N>::max_exponent) {
+        cells[k]++;
+        result.score += surge::u64{1} << cells[k];
+
+        std::copy(cells.begin() + k + 2, cells.begin() + count, cells.begin() + k + 1);
+        count--;
+        cells[count] = 0;
+        break;
+      }
+    }
+
+    for (surge::u8 k = 0; k < count; k++) {
+      set(result.board, board::line_slot(d, i, k, N), cells[k]);
+    }
+  }
+
+  result.changed = !(result.board == g);
+  return result;
+}
+
+template <surge::u8 N> auto move(const grid<N> &g, board::direction d) noexcept -> move_result<N> {
+  if constexpr (N == 4) {
+    const auto moved{board::move(g.s, d)};
+    return move_result<N>{grid<N>{moved.board}, moved.score, moved.changed};
+  } else {
+    return generic_move(g, d);
+  }
+}
+
+/*
+ * Mask of the moves that change the board, with board::move_bit(d) set for each legal direction
+ */
+template <surge::u8 N> auto legal_moves(const grid<N> &g) noexcept -> surge::u8 {
+  if constexpr (N == 4) {
+    return board::legal_moves(g.s);
+  } else {
+    using board::direction;
+
+    surge::u8 legal{0};
+    for (const auto d : {direction::up, direction::down, direction::left, direction::right}) {
+      legal = static_cast<surge::u8>(legal | (move(g, d).changed ? board::move_bit(d) : 0u));
+    }
+    return legal;
+  }
+}
+
+/*
+ * Puts a 2 or a 4 on a uniformly drawn empty slot, with the draws of spawner::spawn. spawn below
+ * goes through spawner::spawn itself for the sizes packed like board_t, so 4x4 games reproduce
+ * the games of the other tools, and 2048_check compares the two.
+ */
+template <surge::u8 N>
+auto generic_spawn(rng::generator &gen, const spawner::config &cfg, const grid<N> &g) noexcept
+    -> grid<N> {
+  auto empty{empty_mask(g)};
+  if (empty == 0) {
+    return g;
+  }
+
+  const auto exponent{spawner::draw_exponent(gen, cfg.two_probability)};
+  const auto n{spawner::draw_index(gen, static_cast<surge::u64>(std::popcount(empty)))};
+
+  for (surge::u8 i = 0; i < n; i++) {
+    empty &= empty - 1;
+  }
+
+  auto spawned{g};
+  set(spawned, static_cast<surge::u8>(std::countr_zero(empty)), exponent);
+  return spawned;
+}
+
+template <surge::u8 N>
+auto spawn(rng::generator &gen, const spawner::config &cfg, const grid<N> &g) noexcept -> grid<N> {
+  if constexpr (N <= 4) {
+    return grid<N>{spawner::spawn(gen, cfg, g.s, N)};
+  } else {
+    return generic_spawn(gen, cfg, g);
+  }
+}
+
+/*
+ * Same as move(g, d) and spawn(gen, cfg, g), also appending the tracks of the move or the spawn,
+ * for the boards the game shows. Those are the sizes packed like board_t, whose tiles fit the
+ * piece IDs and the track list.
+ */
+template <surge::u8 N>
+auto move(const grid<N> &g, board::direction d, board::track_list &tracks) noexcept
+    -> move_result<N> {
+  static_assert(N <= 4, "Only boards up to 4x4 are animated");
+
+  if constexpr (N == 4) {
+    const auto moved{board::move(g.s, d, tracks)};
+    return move_result<N>{grid<N>{moved.board}, moved.score, moved.changed};
+  } else {
+    board::append_tracks(g.s, d, N, tracks);
+    return generic_move(g, d);
+  }
+}
+
+template <surge::u8 N>
+auto spawn(rng::generator &gen, const spawner::config &cfg, const grid<N> &g,
+           board::track_list &tracks) noexcept -> grid<N> {
+  static_assert(N <= 4, "Only boards up to 4x4 are animated");
+  return grid<N>{spawner::spawn(gen, cfg, g.s, tracks, N)};
+}
+
+} // namespace s2048::grid
+
+#endif // SURGE_MODULE_2048_GRID_HPP
@@ -0,0 +1,43 @@
+#ifndef SURGE_MODULE_2048_MAPPED_FILE_HPP
+#define SURGE_MODULE_2048_MAPPED_FILE_HPP
+
+#include "sc_integer_types.hpp"
+
+#include <cstddef>
+
+namespace s2048::mapped_file {
+
+// A mapping of a whole file
+struct mapping {
+  const std::byte *data{nullptr};
+  surge::u64 size{0};
+
+  // Same bytes as data, set only for mappings made with create
+  std::byte *writable_data{nullptr};
+
+#ifdef _WIN32
+  void *file{nullptr};
+  void *map{nullptr};
+#endif
+};
+
+/*
+ * Maps the file at path read only. The mapping is shared, so it follows a file that another
+ * process writes through create, such as the metrics ring. Returns false, leaving m empty, when
+ * the file is missing, empty or can not be mapped.
+ */
+auto open(mapping &m, const char *path) noexcept -> bool;
+
+/*
+ * Maps the file at path shared and writable, so other processes mapping the file see the writes
+ * as they happen. A file that already has size bytes is mapped as it is, contents kept. Otherwise
+ * a file of size zeroed bytes replaces it. On POSIX the replacement is renamed over the old file,
+ * which is never truncated under a reader that has it mapped.
+ */
+auto create(mapping &m, const char *path, surge::u64 size) noexcept -> bool;
+
+void close(mapping &m) noexcept;
+
+} // namespace s2048::mapped_file
+
+#endif // SURGE_MODULE_2048_MAPPED_FILE_HPP
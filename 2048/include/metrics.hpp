@@ -0,0 +1,126 @@
+#ifndef SURGE_MODULE_2048_METRICS_HPP
+#define SURGE_MODULE_2048_METRICS_HPP
+
+#include "mapped_file.hpp"
+#include "sc_integer_types.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace s2048::metrics {
+
+/*
+ * Always on frame metrics. Every build samples the phases of a frame with the steady clock (a few
+ * tens of nanoseconds per sample) and publishes one record per frame into a ring that lives in a
+ * memory mapped file, so an external tool (2048_metrics) can tail it while the game runs.
+ */
+enum phase : surge::u8 { ui, logic, text, sprites, frame, draw, phase_count };
+
+struct frame_record {
+  surge::u64 frame;
+
+  // Steady clock at the end of the frame, in nanoseconds
+  surge::u64 time_ns;
+
+  // The draw phase is the one of the previous frame, which runs after its record is published
+  std::array<surge::u32, phase_count> phase_ns;
+
+  // Moves resolved during the frame and the time spent resolving them
+  surge::u32 moves;
+  surge::u32 move_ns;
+
+  // Sprites and glyphs handed to the GPU side. 0 on frames where nothing changed
+  surge::u32 sprites;
+  surge::u32 glyphs;
+
+  // Snapshots handed to the autosaver
+  surge::u32 saves;
+
+  // Heap allocations made by the module since the previous record. Only counted in Debug builds
+  surge::u32 allocations;
+};
+
+static_assert(sizeof(frame_record) == 64);
+
+/*
+ * Ring file layout: this header, then capacity records. The writer fills record
+ * written % capacity, then publishes it by incrementing written with release ordering. A reader
+ * copies records up to written and discards any it copied while written moved capacity or more
+ * past them, since the writer may have been overwriting it.
+ */
+constexpr const std::array<char, 4> magic{'S', '2', 'M', 'T'};
+constexpr const surge::u32 version{3};
+
+struct ring_header {
+  std::array<char, 4> magic;
+  surge::u32 version;
+  surge::u32 record_size;
+  surge::u32 capacity;
+  std::atomic<surge::u64> written;
+  std::array<surge::u64, 5> reserved;
+};
+
+static_assert(sizeof(ring_header) == 64);
+static_assert(std::atomic<surge::u64>::is_always_lock_free);
+
+struct recorder {
+  mapped_file::mapping file{};
+  ring_header *header{nullptr};
+  frame_record *records{nullptr};
+
+  // Ring storage when the file can not be created, so sampling works the same without it
+  std::vector<frame_record> fallback{};
+  surge::u32 capacity{0};
+  surge::u64 written{0};
+
+  frame_record current{};
+};
+
+/*
+ * Starts a ring of capacity records in the file at path, or continues the one already there when
+ * it has the same layout, as after a hot reload. When the file can not be created, the ring is
+ * kept in memory and false is returned.
+ */
+auto open(recorder &r, const char *path, surge::u32 capacity) noexcept -> bool;
+void close(recorder &r) noexcept;
+
+inline auto now() noexcept -> surge::u64 {
+  const auto t{std::chrono::steady_clock::now().time_since_epoch()};
+  return static_cast<surge::u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count());
+}
+
+inline void add_time(recorder &r, phase p, surge::u64 ns) noexcept {
+  r.current.phase_ns[p] += static_cast<surge::u32>(ns);
+}
+
+// Adds the time from its construction to its destruction to a phase
+class scoped_phase {
+public:
+  scoped_phase(recorder &r, phase p) noexcept : rec{r}, ph{p}, start{now()} {}
+  ~scoped_phase() noexcept { add_time(rec, ph, now() - start); }
+
+  scoped_phase(const scoped_phase &) = delete;
+  auto operator=(const scoped_phase &) -> scoped_phase & = delete;
+
+private:
+  recorder &rec;
+  phase ph;
+  surge::u64 start;
+};
+
+inline void add_move(recorder &r, surge::u64 ns) noexcept {
+  r.current.moves++;
+  r.current.move_ns += static_cast<surge::u32>(ns);
+}
+
+// Publishes the record of the frame that ends and starts a new one
+void end_frame(recorder &r) noexcept;
+
+// Most recent record, or nullptr before the first frame ends
+auto last(const recorder &r) noexcept -> const frame_record *;
+
+} // namespace s2048::metrics
+
+#endif // SURGE_MODULE_2048_METRICS_HPP
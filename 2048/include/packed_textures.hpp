@@ -0,0 +1,42 @@
+#ifndef SURGE_MODULE_2048_PACKED_TEXTURES_HPP
+#define SURGE_MODULE_2048_PACKED_TEXTURES_HPP
+
+#include "asset_pack.hpp"
+#include "type_aliases.hpp"
+
+#include <array>
+#include <optional>
+
+namespace s2048::packed_textures {
+
+constexpr const surge::usize max_textures{16};
+
+// Resident bindless textures uploaded from an asset pack
+struct texture_set {
+  std::array<decltype(asset_pack::entry::name), max_textures> names{};
+  std::array<GLuint, max_textures> textures{};
+  std::array<GLuint64, max_textures> handles{};
+  surge::u8 size{0};
+};
+
+/*
+ * Uploads every texture of the pack straight from its mapping, with mipmaps and anisotropic
+ * filtering. The pack may be closed once this returns.
+ */
+auto upload(texture_set &ts, const asset_pack::pack &p) noexcept -> bool;
+
+/*
+ * Uploads one tightly packed RGBA8 image the same way, under name. The pixels may be freed once
+ * this returns.
+ */
+auto add(texture_set &ts, const char *name, surge::u32 width, surge::u32 height,
+         const void *pixels) noexcept -> bool;
+
+// Same contract as texture::database::find
+auto find(const texture_set &ts, const char *name) noexcept -> std::optional<GLuint64>;
+
+void destroy(texture_set &ts) noexcept;
+
+} // namespace s2048::packed_textures
+
+#endif // SURGE_MODULE_2048_PACKED_TEXTURES_HPP
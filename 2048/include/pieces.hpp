@@ -1,106 +1,133 @@
 #ifndef SURGE_MODULE_2048_PIECES
 #define SURGE_MODULE_2048_PIECES
 
+#include "board.hpp"
 #include "type_aliases.hpp"
 
 #include <array>
+#include <bit>
 
 namespace s2048::pieces {
 
 using piece_id_queue_t = surge::deque<surge::u8>;
-using piece_positions_t = surge::hash_map<surge::u8, glm::vec2>;
-using piece_values_t = surge::hash_map<surge::u8, surge::u16>;
-using piece_slots_t = surge::hash_map<surge::u8, surge::u8>;
 
-struct pieces_data {
-  piece_id_queue_t ids{};
+// The game plays 4x4 and 3x3 boards, both packed like board_t. Larger sizes only exist headless,
+// through grid::grid<N>.
+constexpr const surge::u8 max_pieces{16};
 
-  piece_positions_t positions{};
+// Piece ID used for empty slots and failed creations
+constexpr const surge::u8 no_piece{max_pieces};
 
-  piece_values_t current_values{};
-  piece_values_t target_values{};
+// The game is won on the first 2048 tile
+constexpr const surge::u8 win_exponent{11};
 
-  piece_slots_t current_slots{};
-  piece_slots_t target_slots{};
-};
+template <typename T> using piece_column_t = std::array<T, max_pieces>;
 
-enum board_element_type : surge::u8 { row, column };
-
-enum board_element_configuration : surge::u8 {
-  // 0 pieces
-  OOOO,
-
-  // 1 Piece combos
-  XOOO,
-  OXOO,
-  OOXO,
-  OOOX,
-
-  // 2 Piece combos
-  XXOO,
-  XOXO,
-  XOOX,
-  OXXO,
-  OXOX,
-  OOXX,
-
-  // 3 Piece combos
-  XXXO,
-  XXOX,
-  XOXX,
-  OXXX,
-
-  // 4 Piece combos
-  XXXX
-};
+/*
+ * Structure of arrays indexed by piece ID. Bit i of occupied is set when piece i is alive, and
+ * slot_ids maps each slot to the ID of the piece currently resting on it.
+ */
+struct pieces_data {
+  surge::u16 occupied{0};
 
-struct board_element {
-  std::array<surge::u8, 4> data{};
-  surge::u8 size{};
-  board_element_configuration config{};
-};
+  piece_column_t<glm::vec2> positions{};
+
+  // Tiles are stored as exponents, value = 2^exponent, as on the packed board
+  piece_column_t<surge::u8> current_exponents{};
+  piece_column_t<surge::u8> target_exponents{};
 
-struct board_address {
-  surge::u8 row{};
-  surge::u8 col{};
+  piece_column_t<surge::u8> current_slots{};
+  piece_column_t<surge::u8> target_slots{};
+
+  piece_column_t<surge::u8> slot_ids{[]() {
+    piece_column_t<surge::u8> ids{};
+    ids.fill(no_piece);
+    return ids;
+  }()};
 };
 
-auto create_piece(pieces_data &pd, surge::u16 value, surge::u8 slot) noexcept -> surge::u8;
-void delete_piece(pieces_data &pd, surge::u8 piece_id) noexcept;
+/*
+ * Places the slots in a window of the given size, the resolution read from config.yaml. The
+ * board art is laid out for 500x800 and stretched to the window, so slot positions scale with
+ * each axis while pieces stay square.
+ */
+void set_layout(glm::vec2 window_dims) noexcept;
 
-auto create_random(pieces_data &pd) noexcept -> surge::u8;
+// Lays the slots out again for a board of side x side slots, 4 until set, in the same window
+void set_side(surge::u8 side) noexcept;
 
-auto idle(const pieces_data &pd) noexcept -> bool;
+// Size pieces are drawn at under the current layout
+auto tile_size() noexcept -> glm::vec2;
 
-auto game_over(const pieces_data &pd, float ww, float wh, txd_t &txd) noexcept -> bool;
+// A point or size of the 500x800 reference, stretched to the window with the board art
+auto to_window(glm::vec2 reference) noexcept -> glm::vec2;
 
-auto deflatten_slot(surge::u8 slot) noexcept -> board_address;
-auto get_element(const pieces_data &pd, board_element_type type, surge::u16 value) noexcept
-    -> board_element;
+/*
+ * Calls f(id) for every live piece, in increasing ID order
+ */
+template <typename F> inline void for_each_piece(const pieces_data &pd, F &&f) noexcept {
+  for (auto bits{pd.occupied}; bits != 0; bits = static_cast<surge::u16>(bits & (bits - 1))) {
+    f(static_cast<surge::u8>(std::countr_zero(bits)));
+  }
+}
 
-void compress_right(pieces_data &pd, bool &should_add_new_piece) noexcept;
-void merge_right(pieces_data &pd, piece_id_queue_t &stale_pieces, bool &should_add_new_piece,
-                 surge::u32 &game_score) noexcept;
+auto create_piece(pieces_data &pd, surge::u8 exponent, surge::u8 slot) noexcept -> surge::u8;
+void delete_piece(pieces_data &pd, surge::u8 piece_id) noexcept;
 
-void compress_left(pieces_data &pd, bool &should_add_new_piece) noexcept;
-void merge_left(pieces_data &pd, piece_id_queue_t &stale_pieces, bool &should_add_new_piece,
-                surge::u32 &game_score) noexcept;
+auto idle(const pieces_data &pd) noexcept -> bool;
 
-void compress_up(pieces_data &pd, bool &should_add_new_piece) noexcept;
-void merge_up(pieces_data &pd, piece_id_queue_t &stale_pieces, bool &should_add_new_piece,
-              surge::u32 &game_score) noexcept;
+// End of game message of b, nullptr while the game goes on. legal_moves is the
+// board::legal_moves mask of b. In keep playing mode only running out of moves ends the game.
+auto game_over(board::board_t b, surge::u8 legal_moves, bool keep_playing) noexcept
+    -> const char *;
 
-void compress_down(pieces_data &pd, bool &should_add_new_piece) noexcept;
-void merge_down(pieces_data &pd, piece_id_queue_t &stale_pieces, bool &should_add_new_piece,
-                surge::u32 &game_score) noexcept;
+auto to_board(const pieces_data &pd) noexcept -> board::board_t;
+void from_board(pieces_data &pd, board::board_t b) noexcept;
 
 void mark_stale(piece_id_queue_t &stale_pieces, surge::u8 piece) noexcept;
 void remove_stale(piece_id_queue_t &stale_pieces, pieces_data &pd) noexcept;
 
-auto value_to_texture_handle(const tdb_t &tdb, surge::u16 value) noexcept -> GLuint64;
-void add_sprites_to_database(const tdb_t &tdb, sdb_t &sdb, pieces_data &pd) noexcept;
-
-void update_positions(pieces_data &pd) noexcept;
+// Tile face handles indexed by exponent, up to the largest tile a board nibble holds
+using tile_handles_t = std::array<GLuint64, 16>;
+
+// Tile face textures indexed by exponent
+constexpr const std::array<const char *, 12> tile_faces{
+    nullptr,
+    "resources/pieces_2.png",
+    "resources/pieces_4.png",
+    "resources/pieces_8.png",
+    "resources/pieces_16.png",
+    "resources/pieces_32.png",
+    "resources/pieces_64.png",
+    "resources/pieces_128.png",
+    "resources/pieces_256.png",
+    "resources/pieces_512.png",
+    "resources/pieces_1024.png",
+    "resources/pieces_2048.png"};
+
+// Largest exponent with a face of its own. Larger tiles reuse it with their value printed over it.
+constexpr const surge::u8 last_face{tile_faces.size() - 1};
+
+/*
+ * Looks the faces up with find(name) -> std::optional<GLuint64>, so it has to run again whenever
+ * the textures are loaded again
+ */
+template <typename F> auto tile_handles(F &&find) noexcept -> tile_handles_t {
+  tile_handles_t handles{};
+  for (surge::usize e = 1; e < tile_faces.size(); e++) {
+    handles[e] = find(tile_faces[e]).value_or(0);
+  }
+  for (surge::usize e = tile_faces.size(); e < handles.size(); e++) {
+    handles[e] = handles[last_face];
+  }
+  return handles;
+}
+
+// Slides the moving pieces towards their target slots by dt seconds worth of motion
+void update_positions(pieces_data &pd, float dt) noexcept;
+
+// Ends every slide, placing the moving pieces on their target slots
+void settle(pieces_data &pd) noexcept;
 void update_exponents(pieces_data &pd) noexcept;
 
 } // namespace s2048::pieces
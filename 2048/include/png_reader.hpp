@@ -0,0 +1,30 @@
+#ifndef SURGE_MODULE_2048_PNG_READER_HPP
+#define SURGE_MODULE_2048_PNG_READER_HPP
+
+#include "sc_integer_types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace s2048::png_reader {
+
+// A decoded image, as tightly packed RGBA8 rows, top row first
+struct image {
+  std::vector<std::byte> pixels{};
+  surge::u32 width{0};
+  surge::u32 height{0};
+
+  // Why decoding failed, as reported by libpng
+  std::array<char, 64> error{};
+};
+
+/*
+ * Decodes the PNG file at path into img. Shared by 2048_pack and the module, so a pack holds the
+ * same pixels the module would decode. Returns false, with img.error set, on failure.
+ */
+auto decode(const char *path, image &img) noexcept -> bool;
+
+} // namespace s2048::png_reader
+
+#endif // SURGE_MODULE_2048_PNG_READER_HPP
@@ -0,0 +1,20 @@
+#ifndef SURGE_MODULE_2048_PNG_TEXTURES_HPP
+#define SURGE_MODULE_2048_PNG_TEXTURES_HPP
+
+#include "packed_textures.hpp"
+
+#include <span>
+
+namespace s2048::png_textures {
+
+/*
+ * Decodes the PNG files at paths on the scheduler workers while the calling thread, which owns
+ * the GL context, uploads each image through packed_textures::add as soon as it is decoded. The
+ * textures are named after their paths. Returns false when any file can not be decoded or
+ * uploaded, leaving the ones added before it in ts.
+ */
+auto load(packed_textures::texture_set &ts, std::span<const char *const> paths) noexcept -> bool;
+
+} // namespace s2048::png_textures
+
+#endif // SURGE_MODULE_2048_PNG_TEXTURES_HPP
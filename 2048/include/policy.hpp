@@ -0,0 +1,121 @@
+#ifndef SURGE_MODULE_2048_POLICY_HPP
+#define SURGE_MODULE_2048_POLICY_HPP
+
+#include "grid.hpp"
+#include "rng.hpp"
+#include "solver.hpp"
+
+#include <array>
+#include <bit>
+
+namespace s2048::policy {
+
+/*
+ * Move choosers for headless play on any board size, from cheapest to strongest:
+ * random  - a uniformly drawn legal move
+ * greedy  - the move that scores the most now, then the one leaving the most empty slots
+ * corner  - greedy between down and left, falling back to right then up, which keeps the
+ *           largest tiles in the bottom left corner
+ * solver  - the expectimax search of solver::search, 4x4 only
+ */
+enum class kind : surge::u8 { random, greedy, corner, solver };
+
+// Per thread player state. rng is only drawn by the random policy, ctx and cfg by the solver.
+struct player {
+  kind policy{kind::solver};
+  rng::generator rng{};
+  solver::context ctx{};
+  solver::config cfg{};
+};
+
+struct choice {
+  board::direction move{board::direction::up};
+  bool has_move{false};
+};
+
+auto parse(const char *name, kind &k) noexcept -> bool;
+auto name(kind k) noexcept -> const char *;
+
+// Score of the move first, empty slots left after it second
+template <surge::u8 N>
+auto greedy_value(const grid::grid<N> &g, board::direction d) noexcept -> surge::u64 {
+  const auto moved{grid::move(g, d)};
+  const auto empty{std::popcount(grid::empty_mask(moved.board))};
+  return (moved.score << 7) | static_cast<surge::u64>(empty);
+}
+
+// Best of the legal directions in order, the earlier one winning ties
+template <surge::u8 N, std::size_t M>
+auto greedy(const grid::grid<N> &g, surge::u8 legal,
+            const std::array<board::direction, M> &order) noexcept -> choice {
+  choice c{};
+  surge::u64 best{0};
+
+  for (const auto d : order) {
+    if ((legal & board::move_bit(d)) == 0) {
+      continue;
+    }
+
+    const auto value{greedy_value(g, d)};
+    if (!c.has_move || value > best) {
+      c = choice{d, true};
+      best = value;
+    }
+  }
+
+  return c;
+}
+
+/*
+ * Picks the move of p.policy on g. has_move is false once no move changes the board, and always
+ * for the solver on boards other than 4x4.
+ */
+template <surge::u8 N> auto choose(player &p, const grid::grid<N> &g) noexcept -> choice {
+  using board::direction;
+
+  if (p.policy == kind::solver) {
+    if constexpr (N == 4) {
+      const auto r{solver::search(p.ctx, g.s, p.cfg)};
+      return choice{r.best, r.has_move};
+    } else {
+      return choice{};
+    }
+  }
+
+  const auto legal{grid::legal_moves(g)};
+  if (legal == 0) {
+    return choice{};
+  }
+
+  switch (p.policy) {
+  case kind::random: {
+    // Same multiply and shift mapping as the spawner, onto the set bits of legal
+    const auto count{static_cast<surge::u64>(std::popcount(legal))};
+    const auto n{static_cast<surge::u8>(((rng::next(p.rng) >> 32) * count) >> 32)};
+    return choice{static_cast<direction>(board::select_slot(legal, n)), true};
+  }
+
+  case kind::greedy:
+    return greedy(g, legal, std::array{direction::up, direction::down, direction::left,
+                                       direction::right});
+
+  case kind::corner: {
+    const auto c{greedy(g, legal, std::array{direction::down, direction::left})};
+    if (c.has_move) {
+      return c;
+    }
+    return greedy(g, legal, std::array{direction::right, direction::up});
+  }
+
+  default:
+    return choice{};
+  }
+}
+
+inline auto choose(player &p, board::board_t b) noexcept -> choice {
+  return choose(p, grid::grid<4>{b});
+}
+
+} // namespace s2048::policy
+
+#endif // SURGE_MODULE_2048_POLICY_HPP
@@ -0,0 +1,31 @@
+#ifndef SURGE_MODULE_2048_REPLAY_HPP
+#define SURGE_MODULE_2048_REPLAY_HPP
+
+#include "save_game.hpp"
+
+namespace s2048::replay {
+
+struct result {
+  board::board_t board{0};
+  surge::u64 score{0};
+
+  // Moves played before the replay ended
+  surge::u32 moves{0};
+
+  // Every recorded move changed the board
+  bool legal{true};
+
+  // The replay ended on the board and score stored in the save
+  bool matches{false};
+};
+
+/*
+ * Plays the recorded game of s again, on a board of its size, from its starting generator and
+ * spawn config: the two opening spawns, then every move followed by its spawn. Stops early on a
+ * move that does not change the board, which the game never records.
+ */
+auto run(const save_game::save &s) noexcept -> result;
+
+} // namespace s2048::replay
+
+#endif // SURGE_MODULE_2048_REPLAY_HPP
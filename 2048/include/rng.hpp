@@ -0,0 +1,56 @@
+#ifndef SURGE_MODULE_2048_RNG_HPP
+#define SURGE_MODULE_2048_RNG_HPP
+
+#include "sc_integer_types.hpp"
+
+#include <array>
+
+namespace s2048::rng {
+
+/*
+ * xoshiro256** 1.0 (Blackman and Vigna). Fully specified, so a generator state reproduces the
+ * same sequence on every platform, and small enough to be copied into saves and replays.
+ */
+struct generator {
+  std::array<surge::u64, 4> s{};
+};
+
+inline auto next(generator &g) noexcept -> surge::u64 {
+  auto &s{g.s};
+
+  const auto rotl{[](surge::u64 x, int k) { return (x << k) | (x >> (64 - k)); }};
+
+  const auto result{rotl(s[1] * 5, 7) * 9};
+  const auto t{s[1] << 17};
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+
+  return result;
+}
+
+// Expands a 64 bit seed into a full state with splitmix64, as recommended by the authors
+auto from_seed(surge::u64 seed) noexcept -> generator;
+
+/*
+ * Generator number index of the family keyed by seed. Streams are derived from (seed, index)
+ * alone, so a parallel run gets the same stream for the same index whichever thread asks for it
+ * and in whatever order. Reaching stream i with jump would take i jumps, so games are keyed by
+ * hashing instead, and jump is left for splitting one stream into a few non overlapping ones.
+ */
+auto stream(surge::u64 seed, surge::u64 index) noexcept -> generator;
+
+/*
+ * Advances g by 2^128 draws. Calling it n times on copies of one generator splits its sequence
+ * into n non overlapping streams of 2^128 draws each.
+ */
+void jump(generator &g) noexcept;
+
+} // namespace s2048::rng
+
+#endif // SURGE_MODULE_2048_RNG_HPP
@@ -0,0 +1,89 @@
+#ifndef SURGE_MODULE_2048_SAVE_GAME_HPP
+#define SURGE_MODULE_2048_SAVE_GAME_HPP
+
+#include "board.hpp"
+#include "rng.hpp"
+
+#include <array>
+#include <vector>
+
+namespace s2048::save_game {
+
+/*
+ * Binary save file: a fixed header followed by the optional move history, packed as 2 bit
+ * board::direction codes, four per byte, first move in the low bits. All fields are little endian.
+ */
+constexpr const std::array<char, 4> magic{'S', '2', 'S', 'V'};
+constexpr const surge::u32 version{3};
+
+// header::flags bits
+constexpr const surge::u32 keep_playing_flag{1};
+
+struct header {
+  std::array<char, 4> magic;
+  surge::u32 version;
+  board::board_t board;
+  surge::u64 score;
+  surge::u64 best_score;
+  surge::u32 move_count;
+
+  // spawner::config of the game
+  float two_probability;
+
+  surge::u32 flags;
+
+  // Side of the board. 0 in files written before 3x3 games, which are all 4x4
+  surge::u32 size;
+
+  // Generator now, and when the game started, which together with the history replays the game
+  std::array<surge::u64, 4> rng;
+  std::array<surge::u64, 4> start_rng;
+};
+
+static_assert(sizeof(header) == 112);
+
+struct save {
+  // A 3x3 board is the storage of a grid::grid<3>, packed like board_t on its first 9 slots
+  board::board_t board{0};
+  surge::u8 size{4};
+
+  surge::u64 score{0};
+  surge::u64 best_score{0};
+  float two_probability{0.5f};
+
+  // The game goes on past the first 2048
+  bool keep_playing{false};
+
+  rng::generator rng{};
+  rng::generator start_rng{};
+
+  surge::u32 move_count{0};
+  std::vector<surge::u8> moves{};
+};
+
+// Appends d to the packed history of s
+void record_move(save &s, board::direction d) noexcept;
+auto recorded_move(const save &s, surge::u32 index) noexcept -> board::direction;
+
+// Serializes s as it is stored in a save file
+void encode(const save &s, std::vector<surge::u8> &bytes) noexcept;
+
+/*
+ * Restores s from the bytes of a save file. Returns false when they are not a valid save. Older
+ * versions keep their board and best score; version 1 saves lose their history, which the current
+ * generator can not replay. Boards other than 3x3 and 4x4 are rejected.
+ */
+auto decode(const surge::u8 *data, surge::u64 size, save &s) noexcept -> bool;
+
+/*
+ * Writes s next to path first, then renames it over path, so a crash mid write never leaves a
+ * truncated save behind
+ */
+auto write(const char *path, const save &s) noexcept -> bool;
+
+// Maps the file and decodes it in place. Returns false when it is missing or invalid
+auto read(const char *path, save &s) noexcept -> bool;
+
+} // namespace s2048::save_game
+
+#endif // SURGE_MODULE_2048_SAVE_GAME_HPP
@@ -0,0 +1,31 @@
+#ifndef SURGE_MODULE_2048_SCHEDULER_HPP
+#define SURGE_MODULE_2048_SCHEDULER_HPP
+
+#include "sc_integer_types.hpp"
+
+#include <functional>
+
+namespace s2048::scheduler {
+
+struct options {
+  // 0 uses every hardware thread
+  surge::u32 threads{0};
+
+  // Pin worker i to logical CPU i (modulo the CPU count)
+  bool pin{false};
+};
+
+using job_t = std::function<void(surge::u64 index, surge::u32 worker)>;
+
+auto worker_count(const options &opts) noexcept -> surge::u32;
+
+/*
+ * Runs job(index, worker) for every index in [0, count). Each worker starts with an equal
+ * contiguous share of the indices and, once it runs dry, steals half of the remaining share of
+ * another worker. Returns when every index has been processed.
+ */
+void parallel_for(surge::u64 count, const options &opts, const job_t &job);
+
+} // namespace s2048::scheduler
+
+#endif // SURGE_MODULE_2048_SCHEDULER_HPP
@@ -0,0 +1,74 @@
+#ifndef SURGE_MODULE_2048_SOLVER_HPP
+#define SURGE_MODULE_2048_SOLVER_HPP
+
+#include "board.hpp"
+
+#include <array>
+#include <chrono>
+#include <vector>
+
+namespace s2048::solver {
+
+struct config {
+  // Wall clock budget for the whole search. Iterative deepening stops at the first iteration that
+  // does not finish in time and reports the last complete one.
+  std::chrono::microseconds budget{5000};
+
+  surge::u8 max_depth{8};
+
+  // Chance nodes reached with a lower probability than this are evaluated with the heuristic
+  float probability_cutoff{0.0001f};
+
+  // Probability of a spawned piece being a 2. Set it from the spawner::config of the game
+  float two_probability{0.5f};
+};
+
+/*
+ * Value of board searched depth plies deep. Chance nodes below probability_cutoff are cut off, so
+ * the value is only as deep as the probability the board was reached with, which is kept too.
+ */
+struct tt_entry {
+  board::board_t board{0};
+  float value{0.0f};
+  float probability{0.0f};
+  surge::u8 depth{0};
+};
+
+/*
+ * Per thread search state. The transposition table is kept between searches, since the value of
+ * a board at a given depth does not depend on where it was reached from.
+ */
+struct context {
+  std::vector<tt_entry> table{};
+  surge::u64 table_mask{0};
+
+  surge::u64 nodes{0};
+  std::chrono::steady_clock::time_point deadline{};
+  bool aborted{false};
+};
+
+struct result {
+  // Expected heuristic value of each move, indexed by board::direction. Moves that do not change
+  // the board are 0.
+  std::array<float, 4> values{0.0f, 0.0f, 0.0f, 0.0f};
+
+  board::direction best{board::direction::up};
+  bool has_move{false};
+
+  // Deepest iteration that finished inside the budget
+  surge::u8 depth{0};
+  surge::u64 nodes{0};
+};
+
+auto create_context(surge::u8 table_bits = 20) noexcept -> context;
+
+// Empties the transposition table, so the next searches do not depend on the previous ones
+void clear(context &ctx) noexcept;
+
+auto heuristic(board::board_t b) noexcept -> float;
+
+auto search(context &ctx, board::board_t b, const config &cfg) noexcept -> result;
+
+} // namespace s2048::solver
+
+#endif // SURGE_MODULE_2048_SOLVER_HPP
@@ -0,0 +1,37 @@
+#ifndef SURGE_MODULE_2048_SPAWNER_HPP
+#define SURGE_MODULE_2048_SPAWNER_HPP
+
+#include "board.hpp"
+#include "rng.hpp"
+
+namespace s2048::spawner {
+
+struct config {
+  // Probability of a spawned piece being a 2 rather than a 4
+  float two_probability{0.5f};
+};
+
+/*
+ * Puts a 2 or a 4 on a uniformly drawn empty slot of b and appends its track. Draws come from g
+ * only, through integer arithmetic, so a game is reproduced anywhere from the generator state it
+ * started with, the config and its moves. Smaller boards packed like board_t (3x3, see
+ * board::append_tracks) give their side, so only their own slots are drawn from.
+ */
+auto spawn(rng::generator &g, const config &cfg, board::board_t b, board::track_list &tracks,
+           surge::u8 side = 4) noexcept -> board::board_t;
+
+// Same draws as above, for callers that do not animate
+auto spawn(rng::generator &g, const config &cfg, board::board_t b, surge::u8 side = 4) noexcept
+    -> board::board_t;
+
+/*
+ * The two draws of a spawn, in the order it makes them, for the sized boards of grid.hpp.
+ * draw_exponent gives 1 (a 2) with probability two_probability and 2 (a 4) otherwise, and
+ * draw_index a uniform index in [0, count), the empty slot taken.
+ */
+auto draw_exponent(rng::generator &g, float two_probability) noexcept -> surge::u8;
+auto draw_index(rng::generator &g, surge::u64 count) noexcept -> surge::u8;
+
+} // namespace s2048::spawner
+
+#endif // SURGE_MODULE_2048_SPAWNER_HPP
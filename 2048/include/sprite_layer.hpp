@@ -0,0 +1,51 @@
+#ifndef SURGE_MODULE_2048_SPRITE_LAYER_HPP
+#define SURGE_MODULE_2048_SPRITE_LAYER_HPP
+
+#include "pieces.hpp"
+#include "type_aliases.hpp"
+
+namespace s2048::sprite_layer {
+
+/*
+ * Placement of one sprite. The model matrix is only built when the sprite database is refilled.
+ */
+struct sprite {
+  GLuint64 handle{0};
+  glm::vec2 pos{0.0f};
+  glm::vec2 scale{0.0f};
+  float z{0.0f};
+  float alpha{1.0f};
+
+  auto operator==(const sprite &) const -> bool = default;
+};
+
+/*
+ * Sprites retained between frames. Setting a sprite to what it already holds is a no-op, and the
+ * sprite database is only refilled when something changed, so idle frames add and upload nothing.
+ */
+struct layer_data {
+  sprite background{};
+  sprite button{};
+
+  // Tile sprites by piece ID. visible is the occupancy mask they were last set from
+  pieces::piece_column_t<sprite> tiles{};
+  surge::u16 visible{0};
+
+  bool dirty{true};
+};
+
+void set(layer_data &ld, sprite &s, const sprite &value) noexcept;
+
+// Sets the tile sprites from the pieces, flagging only the tiles that moved, changed or vanished
+void update_tiles(layer_data &ld, const pieces::tile_handles_t &handles,
+                  const pieces::pieces_data &pd) noexcept;
+
+/*
+ * Refills the sprite database if the layer changed since the last commit. Returns the number of
+ * sprites added, 0 when nothing changed.
+ */
+auto commit(layer_data &ld, sdb_t &sdb) noexcept -> surge::u32;
+
+} // namespace s2048::sprite_layer
+
+#endif // SURGE_MODULE_2048_SPRITE_LAYER_HPP
@@ -0,0 +1,56 @@
+#ifndef SURGE_MODULE_2048_TEXT_LAYER_HPP
+#define SURGE_MODULE_2048_TEXT_LAYER_HPP
+
+#include "pieces.hpp"
+#include "type_aliases.hpp"
+
+#include <array>
+
+namespace s2048::text_layer {
+
+// A number and its decimal digits, formatted only when the number changes
+struct number_run {
+  surge::u64 value{0};
+  std::array<char, 24> digits{'0'};
+};
+
+// Value printed over a piece larger than the last tile face
+struct tile_label {
+  glm::vec2 position{0.0f};
+  surge::u8 exponent{0};
+};
+
+/*
+ * Text retained between frames: the two scores, the end of game message and the tile labels. The
+ * text buffer is only reset and shaped again when one of them changes.
+ */
+struct layer_data {
+  number_run current_score{};
+  number_run best_score{};
+
+  // End of game message, nullptr while playing
+  const char *message{nullptr};
+  glm::vec2 window_dims{0.0f};
+
+  std::array<tile_label, pieces::max_pieces> labels{};
+  surge::u8 label_count{0};
+  glm::vec2 tile_size{0.0f};
+
+  bool dirty{true};
+};
+
+void set_number(layer_data &ld, number_run &run, surge::u64 value) noexcept;
+void set_message(layer_data &ld, const char *message, const glm::vec2 &window_dims) noexcept;
+
+// Labels the pieces past pieces::last_face with their value. Sliding labels change every frame.
+void set_labels(layer_data &ld, const pieces::pieces_data &pd, const glm::vec2 &tile_size) noexcept;
+
+/*
+ * Shapes the text again if the layer changed since the last commit. Returns the number of
+ * characters pushed, 0 when nothing changed.
+ */
+auto commit(layer_data &ld, txd_t &txd) noexcept -> surge::u32;
+
+} // namespace s2048::text_layer
+
+#endif // SURGE_MODULE_2048_TEXT_LAYER_HPP
@@ -2,6 +2,7 @@
 #define SURGE_2048_UI_HPP
 
 #include "sc_window.hpp"
+#include "sprite_layer.hpp"
 #include "type_aliases.hpp"
 
 namespace s2048::ui {
@@ -43,8 +44,10 @@ struct button_skin {
   GLuint64 handle_press;
 };
 
-auto button(surge::window::window_t w, surge::i32 id, ui_state &state, draw_data &dd, sdb_t &sdb,
-            const button_skin &bs) noexcept -> bool;
+// The skin to show is set on the given sprite of the layer
+auto button(surge::window::window_t w, surge::i32 id, ui_state &state, draw_data &dd,
+            sprite_layer::layer_data &ld, sprite_layer::sprite &s, const button_skin &bs) noexcept
+    -> bool;
 
 } // namespace s2048::ui
 
@@ -1,54 +1,407 @@
 #include "2048.hpp"
 
+#include "animator.hpp"
+#include "asset_pack.hpp"
+#include "autosave.hpp"
+#include "board.hpp"
+#include "grid.hpp"
+#include "metrics.hpp"
+#include "packed_textures.hpp"
 #include "pieces.hpp"
+#include "save_game.hpp"
+#include "solver.hpp"
+#include "spawner.hpp"
+#include "sprite_layer.hpp"
+#include "text_layer.hpp"
 #include "type_aliases.hpp"
 #include "ui.hpp"
 
 #ifdef SURGE_BUILD_TYPE_Debug
+#  include "alloc_counter.hpp"
 #  include "debug_window.hpp"
 #endif
 
+#ifdef SURGE_MODULE_2048_PNG
+#  include "png_textures.hpp"
+#endif
+
 #include "sc_glm_includes.hpp"
 #include "sc_opengl/atoms/imgui.hpp"
 
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+// Logic rate, independent of the frame rate
+static constexpr const double logic_step{1.0 / 120.0};
+static constexpr const double max_frame_time{0.25};
+
+// Sizes of the GPU side buffers
+static constexpr const surge::u32 sprite_capacity{128};
+static constexpr const surge::u32 glyph_capacity{540};
+
+// Moves pressed ahead of the game
+static constexpr const surge::usize max_buffered_moves{4};
+
+static constexpr const char *save_path{"2048.sav"};
+
+// Module textures, as named by the pack and the texture database
+static constexpr const std::array<const char *, 15> texture_paths{
+    "resources/board.png",          "resources/board_3.png",     "resources/button_press.png",
+    "resources/button_release.png", "resources/pieces_2.png",    "resources/pieces_4.png",
+    "resources/pieces_8.png",       "resources/pieces_16.png",   "resources/pieces_32.png",
+    "resources/pieces_64.png",      "resources/pieces_128.png",  "resources/pieces_256.png",
+    "resources/pieces_512.png",     "resources/pieces_1024.png", "resources/pieces_2048.png"};
+
+// Frame metrics ring, about 4 minutes of frames at 60 Hz
+static constexpr const char *metrics_path{"2048.metrics"};
+static constexpr const surge::u32 metrics_capacity{16384};
+
 namespace globals {
 
 static s2048::tdb_t tdb{};      // NOLINT
 static s2048::pvubo_t pv_ubo{}; // NOLINT
 static s2048::sdb_t sdb{};      // NOLINT
 
+// Textures uploaded from resources/2048.pack, or decoded from the PNGs when the pack is missing
+// and libpng is available. Empty otherwise, in which case the texture database decodes them
+static s2048::packed_textures::texture_set packed_textures{}; // NOLINT
+
 static s2048::txd_t txd{}; // NOLINT
 
-static s2048::pieces::pieces_data pd{};       // NOLINT
-static s2048::pieces::piece_id_queue_t spc{}; // NOLINT
+static s2048::sprite_layer::layer_data spl{}; // NOLINT
+static s2048::text_layer::layer_data tl{};    // NOLINT
+
+// Texture handles, looked up again on every load since the texture database is rebuilt with it
+static GLuint64 board_handle{0};                     // NOLINT
+static GLuint64 board_3_handle{0};                   // NOLINT
+static GLuint64 button_press_handle{0};              // NOLINT
+static GLuint64 button_release_handle{0};            // NOLINT
+static s2048::pieces::tile_handles_t tile_handles{}; // NOLINT
 
-static s2048::state_queue stq{}; // NOLINT
+// The logical board. Moves are resolved on it at once, the pieces only animate it. 3x3 games
+// keep the storage of a grid::grid<3> in it
+static s2048::board::board_t board{0}; // NOLINT
 
-static surge::u32 current_score{0}; // NOLINT
-static surge::u32 best_score{0};    // NOLINT
+// Side of the logical board, 3 or 4
+static surge::u8 board_size{4}; // NOLINT
+
+static s2048::pieces::pieces_data pd{};     // NOLINT
+static s2048::animator::animator_data ad{}; // NOLINT
+
+static s2048::input_queue inq{}; // NOLINT
+
+// board::legal_moves of the logical board
+static surge::u8 legal_moves{0}; // NOLINT
+
+// Time not yet consumed by fixed logic steps
+static double logic_time{0.0}; // NOLINT
+
+// Spawn generator, seeded per process. Saves carry its state, so loaded games continue their own
+static s2048::rng::generator rng{s2048::rng::from_seed(std::random_device{}())}; // NOLINT
+static s2048::spawner::config spawn_cfg{};                                      // NOLINT
+
+static surge::u64 current_score{0}; // NOLINT
+static surge::u64 best_score{0};    // NOLINT
+
+// Set once the player goes on past the first 2048
+static bool keep_playing{false}; // NOLINT
+
+// RNG state at the start of the game and the moves played since, for saves and replays
+static s2048::save_game::save record{}; // NOLINT
+
+// Set when the game changed since the last snapshot handed to the autosaver
+static bool unsaved{false};                    // NOLINT
+static s2048::autosave::autosaver autosaver{}; // NOLINT
+
+static s2048::metrics::recorder metrics{}; // NOLINT
 
 #ifdef SURGE_BUILD_TYPE_Debug
 static ImGuiContext *imgui_ctx{nullptr}; // NOLINT
 static bool show_debug_window{true};     // NOLINT
+
+static s2048::solver::context solver_ctx{}; // NOLINT
+
+// Allocation count when the previous frame record was published
+static surge::u64 allocations{0}; // NOLINT
 #endif
 
 } // namespace globals
 
+static void update_legal_moves() noexcept {
+  using namespace s2048;
+  globals::legal_moves = globals::board_size == 3
+                             ? grid::legal_moves(grid::grid<3>{globals::board})
+                             : board::legal_moves(globals::board);
+}
+
+static auto can_move(s2048::board::direction d) noexcept -> bool {
+  return (globals::legal_moves & s2048::board::move_bit(d)) != 0;
+}
+
+static auto game_finished() noexcept -> bool {
+  return s2048::pieces::game_over(globals::board, globals::legal_moves, globals::keep_playing)
+         != nullptr;
+}
+
+// Plays d and the spawn that follows it on the logical board, as an N x N grid. Returns the score
+template <surge::u8 N>
+static auto move_and_spawn(s2048::board::direction d, s2048::board::track_list &tracks) noexcept
+    -> surge::u64 {
+  using namespace s2048;
+
+  const auto moved{grid::move(grid::grid<N>{globals::board}, d, tracks)};
+  globals::board = grid::spawn(globals::rng, globals::spawn_cfg, moved.board, tracks).s;
+  return moved.score;
+}
+
+// Resolves a move on the logical board and hands its tracks to the animator
+static void play_move(s2048::board::direction d) noexcept {
+  using namespace s2048;
+
+  const auto start{metrics::now()};
+
+  board::track_list tracks{};
+  globals::current_score +=
+      globals::board_size == 3 ? move_and_spawn<3>(d, tracks) : move_and_spawn<4>(d, tracks);
+  save_game::record_move(globals::record, d);
+  globals::unsaved = true;
+
+  update_legal_moves();
+
+  animator::push(globals::ad, tracks);
+
+  metrics::add_move(globals::metrics, metrics::now() - start);
+}
+
+static auto snapshot() noexcept -> const s2048::save_game::save & {
+  auto &s{globals::record};
+  s.board = globals::board;
+  s.size = globals::board_size;
+  s.score = globals::current_score;
+  s.best_score = std::max(globals::best_score, globals::current_score);
+  s.two_probability = globals::spawn_cfg.two_probability;
+  s.keep_playing = globals::keep_playing;
+  s.rng = globals::rng;
+  return s;
+}
+
+// Puts the game of s on the board. Moves still animating when it was taken come back played
+static void restore(const s2048::save_game::save &s) noexcept {
+  using namespace s2048;
+
+  globals::board = s.board;
+  globals::board_size = s.size;
+  globals::current_score = s.score;
+  globals::best_score = s.best_score;
+  globals::spawn_cfg.two_probability = s.two_probability;
+  globals::keep_playing = s.keep_playing;
+  globals::rng = s.rng;
+  globals::record = s;
+
+  pieces::set_side(globals::board_size);
+  pieces::from_board(globals::pd, globals::board);
+  globals::ad = animator::animator_data{};
+  globals::inq.clear();
+  update_legal_moves();
+}
+
+/*
+ * Game handed from one build of the module to the next across a hot reload. Statics die with the
+ * unloaded module but the process environment does not, so this fixed size record travels there
+ * in hex. The move history stays in the save file, which gl_on_unload writes before the reload.
+ */
+static constexpr const char *reload_variable{"SURGE_MODULE_2048_RELOAD_STATE"};
+
+struct reload_state {
+  s2048::board::board_t board;
+  surge::u64 score;
+  surge::u64 best_score;
+  std::array<surge::u64, 4> rng;
+  float two_probability;
+  surge::u8 keep_playing;
+
+  // 0 when stashed by a build without 3x3 games
+  surge::u8 size;
+  std::array<surge::u8, 2> reserved;
+};
+
+static_assert(sizeof(reload_state) == 64);
+
+static void stash_game() noexcept {
+  const auto &s{snapshot()};
+
+  reload_state rs{};
+  rs.board = s.board;
+  rs.score = s.score;
+  rs.best_score = s.best_score;
+  rs.rng = s.rng.s;
+  rs.two_probability = s.two_probability;
+  rs.keep_playing = s.keep_playing ? 1 : 0;
+  rs.size = s.size;
+
+  std::array<surge::u8, sizeof(reload_state)> bytes{};
+  std::memcpy(bytes.data(), &rs, sizeof(reload_state));
+
+  std::string state(2 * bytes.size(), '0');
+  for (surge::usize i = 0; i < bytes.size(); i++) {
+    std::to_chars(&state[2 * i + (bytes[i] < 0x10 ? 1 : 0)], &state[2 * i + 2], bytes[i], 16);
+  }
+
+#if defined(_WIN32)
+  const auto failed{_putenv_s(reload_variable, state.c_str()) != 0};
+#else
+  const auto failed{setenv(reload_variable, state.c_str(), 1) != 0};
+#endif
+
+  if (failed) {
+    log_error("Unable to stash the game for the reload, it resumes from {}", save_path);
+  }
+}
+
+// Picks up the game stashed by the previous build of the module, if there is one
+static auto resume_game() noexcept -> bool {
+  using namespace s2048;
+
+  const auto env{std::getenv(reload_variable)};
+  if (env == nullptr || *env == '\0') {
+    return false;
+  }
+
+  const std::string state{env};
+
+  // Consumed either way, a state that does not parse is not retried on the next reload
+#if defined(_WIN32)
+  _putenv_s(reload_variable, "");
+#else
+  unsetenv(reload_variable);
+#endif
+
+  std::array<surge::u8, sizeof(reload_state)> bytes{};
+  bool ok{state.size() == 2 * bytes.size()};
+
+  for (surge::usize i = 0; ok && i < bytes.size(); i++) {
+    const auto first{&state[2 * i]};
+    ok = std::from_chars(first, first + 2, bytes[i], 16).ptr == first + 2;
+  }
+
+  if (!ok) {
+    log_error("Discarding unreadable hot reload state");
+    return false;
+  }
+
+  reload_state rs{};
+  std::memcpy(&rs, bytes.data(), sizeof(reload_state));
+
+  const auto size{static_cast<surge::u8>(rs.size == 3 ? 3 : 4)};
+
+  // The history comes from the save file written on unload, when it holds the same game
+  save_game::save s{};
+  const auto has_history{save_game::read(save_path, s) && s.board == rs.board
+                         && s.size == size && s.score == rs.score && s.rng.s == rs.rng};
+
+  if (!has_history) {
+    s = save_game::save{};
+    s.start_rng.s = rs.rng;
+  }
+
+  s.board = rs.board;
+  s.size = size;
+  s.score = rs.score;
+  s.best_score = rs.best_score;
+  s.rng.s = rs.rng;
+  s.two_probability = rs.two_probability;
+  s.keep_playing = rs.keep_playing != 0;
+
+  restore(s);
+
+  log_info("Resumed game across reload, score {}{}", globals::current_score,
+           has_history ? "" : ", without its move history");
+  return true;
+}
+
+// Continues the game of the save file, if there is one
+static auto load_game() noexcept -> bool {
+  s2048::save_game::save s{};
+  if (!s2048::save_game::read(save_path, s)) {
+    return false;
+  }
+
+  restore(s);
+
+  log_info("Loaded {}, score {}, best score {}", save_path, globals::current_score,
+           globals::best_score);
+  return true;
+}
+
+#ifdef SURGE_BUILD_TYPE_Debug
+// Once the animator has played every move, the pieces must show the logical board
+static void check_animator() noexcept {
+  using namespace s2048;
+  const auto shown{pieces::to_board(globals::pd)};
+  if (shown != globals::board) {
+    log_error("Animator out of sync: pieces {:#018x}, board {:#018x}", shown, globals::board);
+  }
+}
+#endif
+
+/*
+ * Wall time of each phase of gl_on_load, logged as the phase ends so cold starts and hot reloads
+ * show where their time goes
+ */
+class load_timer {
+public:
+  void lap(const char *phase) noexcept {
+    const auto now{std::chrono::steady_clock::now()};
+    log_info("Load: {:<14} {:8.3f} ms", phase, ms(now - last));
+    last = now;
+  }
+
+  void total() const noexcept {
+    log_info("Load: {:<14} {:8.3f} ms", "total", ms(std::chrono::steady_clock::now() - start));
+  }
+
+private:
+  static auto ms(std::chrono::steady_clock::duration d) noexcept -> double {
+    return std::chrono::duration<double, std::milli>(d).count();
+  }
+
+  std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+  std::chrono::steady_clock::time_point last{start};
+};
+
 extern "C" SURGE_MODULE_EXPORT auto gl_on_load(surge::window::window_t w) -> int {
   using namespace s2048;
   using namespace surge;
 
+  load_timer timer{};
+
+  if (!metrics::open(globals::metrics, metrics_path, metrics_capacity)) {
+    log_info("Unable to create {}, frame metrics are kept in memory only", metrics_path);
+  }
+
+  // The board tables need no GL context, so they are built while the main thread loads GPU
+  // resources. The thread joins on every return path
+  std::jthread board_tables{[]() { board::init(); }};
+
   // Texture database
   globals::tdb = gl_atom::texture::database::create(128);
 
   // Sprite database
-  gl_atom::sprite_database::database_create_info sdb_ci{128, 3};
+  gl_atom::sprite_database::database_create_info sdb_ci{sprite_capacity, 3};
   auto sdb{gl_atom::sprite_database::create(sdb_ci)};
   if (!sdb) {
     log_error("Unable to create sprite database");
     return static_cast<int>(sdb.error());
   }
   globals::sdb = *sdb;
+  globals::spl = sprite_layer::layer_data{};
+  timer.lap("databases");
 
   // Text Engine
   const auto ten_result{gl_atom::text::text_engine::create()};
@@ -65,6 +418,7 @@ extern "C" SURGE_MODULE_EXPORT auto gl_on_load(surge::window::window_t w) -> int
     log_error("Unable to load resources/dejavu_sans_bold.ttf");
     return static_cast<int>(*load_face_result);
   }
+  timer.lap("font face");
 
   // Glyph Caches
   const auto face{globals::txd.ten.get_face("dejavu_sans_bold")};
@@ -81,14 +435,16 @@ extern "C" SURGE_MODULE_EXPORT auto gl_on_load(surge::window::window_t w) -> int
 
   globals::txd.gc = *glyph_cache;
   globals::txd.gc.make_resident();
+  timer.lap("glyph cache");
 
   // Text Buffer
-  const auto text_buffer{gl_atom::text::text_buffer::create(540)};
+  const auto text_buffer{gl_atom::text::text_buffer::create(glyph_capacity)};
   if (!text_buffer) {
     log_error("Unable to create text buffer");
     return static_cast<int>(text_buffer.error());
   }
   globals::txd.txb = *text_buffer;
+  globals::tl = text_layer::layer_data{};
 
   // Initialize global 2D projection matrix and view matrix
   const auto dims{window::get_dims(w)};
@@ -99,50 +455,95 @@ extern "C" SURGE_MODULE_EXPORT auto gl_on_load(surge::window::window_t w) -> int
   // PV UBO
   globals::pv_ubo = gl_atom::pv_ubo::buffer::create();
   globals::pv_ubo.update_all(&projection, &view);
+  pieces::set_layout(dims);
+  timer.lap("buffers");
 
   // Load game resources
-  // All textures
-  gl_atom::texture::create_info ci{};
-  ci.filtering = gl_atom::texture::texture_filtering::anisotropic;
-  globals::tdb.add(ci, "resources/board.png", "resources/button_press.png",
-                   "resources/button_release.png", "resources/pieces_2.png",
-                   "resources/pieces_4.png", "resources/pieces_8.png", "resources/pieces_16.png",
-                   "resources/pieces_32.png", "resources/pieces_64.png", "resources/pieces_128.png",
-                   "resources/pieces_256.png", "resources/pieces_512.png",
-                   "resources/pieces_1024.png", "resources/pieces_2048.png");
-
-  // Init piece ID queue
-  for (surge::u8 i = 0; i < 16; i++) {
-    globals::pd.ids.push_back(i);
+  // All textures, from the baked pack when there is one
+  asset_pack::pack pack{};
+  if (asset_pack::open(pack, "resources/2048.pack")) {
+    const auto uploaded{packed_textures::upload(globals::packed_textures, pack)};
+    asset_pack::close(pack);
+
+    if (!uploaded) {
+      packed_textures::destroy(globals::packed_textures);
+    }
+  } else {
+    log_info("No asset pack found, decoding resources/*.png");
   }
 
-  // Init state stack
-  globals::stq.push_back(game_state::idle);
-
-  // Reserve memory for hash maps
-  globals::pd.positions.reserve(16);
-
-  globals::pd.current_values.reserve(16);
-  globals::pd.target_values.reserve(16);
+#ifdef SURGE_MODULE_2048_PNG
+  // Without a pack, the PNGs are decoded on the scheduler workers and uploaded the same way
+  if (globals::packed_textures.size == 0
+      && !png_textures::load(globals::packed_textures, texture_paths)) {
+    packed_textures::destroy(globals::packed_textures);
+  }
+#endif
 
-  globals::pd.current_slots.reserve(16);
-  globals::pd.target_slots.reserve(16);
+  if (globals::packed_textures.size == 0) {
+    gl_atom::texture::create_info ci{};
+    ci.filtering = gl_atom::texture::texture_filtering::anisotropic;
+    globals::tdb.add(ci, "resources/board.png", "resources/board_3.png",
+                     "resources/button_press.png", "resources/button_release.png",
+                     "resources/pieces_2.png", "resources/pieces_4.png", "resources/pieces_8.png",
+                     "resources/pieces_16.png", "resources/pieces_32.png",
+                     "resources/pieces_64.png", "resources/pieces_128.png",
+                     "resources/pieces_256.png", "resources/pieces_512.png",
+                     "resources/pieces_1024.png", "resources/pieces_2048.png");
+  }
 
-  // Create initial pieces
-  pieces::create_random(globals::pd);
-  pieces::create_random(globals::pd);
+  const auto find_texture{[](const char *name) {
+    return globals::packed_textures.size != 0
+               ? packed_textures::find(globals::packed_textures, name)
+               : globals::tdb.find(name);
+  }};
+
+  globals::board_handle = find_texture("resources/board.png").value_or(0);
+  globals::board_3_handle = find_texture("resources/board_3.png").value_or(0);
+  globals::button_press_handle = find_texture("resources/button_press.png").value_or(0);
+  globals::button_release_handle = find_texture("resources/button_release.png").value_or(0);
+  globals::tile_handles = pieces::tile_handles(find_texture);
+  timer.lap("textures");
+
+  // Board engine tables, usually done by now
+  board_tables.join();
+  timer.lap("board tables");
+
+  // Resume the game of the previous build after a hot reload, then the saved game, or start one
+  if (!resume_game() && !load_game()) {
+    new_game();
+  }
+  autosave::start(globals::autosaver, save_path);
+  timer.lap("game");
 
   // Debug window
 #ifdef SURGE_BUILD_TYPE_Debug
   globals::imgui_ctx = gl_atom::imgui::create(w, imgui::create_config{});
   ImGui::SetCurrentContext(globals::imgui_ctx);
+
+  globals::solver_ctx = solver::create_context(16);
+  timer.lap("debug tools");
 #endif
 
+  timer.total();
+
   return 0;
 }
 
 extern "C" SURGE_MODULE_EXPORT auto gl_on_unload(surge::window::window_t) -> int {
   using namespace surge;
+  using namespace s2048;
+
+  stash_game();
+
+  // The game is written one last time before the writer goes away with the module
+  if (globals::unsaved) {
+    autosave::submit(globals::autosaver, snapshot());
+    globals::unsaved = false;
+  }
+  autosave::stop(globals::autosaver);
+
+  metrics::close(globals::metrics);
 
   globals::txd.txb.destroy();
   globals::txd.gc.destroy();
@@ -152,6 +553,7 @@ extern "C" SURGE_MODULE_EXPORT auto gl_on_unload(surge::window::window_t) -> int
   gl_atom::sprite_database::destroy(globals::sdb);
 
   globals::tdb.destroy();
+  packed_textures::destroy(globals::packed_textures);
 
   // Debug window
 #ifdef SURGE_BUILD_TYPE_Debug
@@ -165,160 +567,130 @@ extern "C" SURGE_MODULE_EXPORT auto gl_draw(surge::window::window_t w) -> int {
   globals::pv_ubo.bind_to_location(2);
 
   // Sprite and text pass
-  surge::gl_atom::sprite_database::draw(globals::sdb);
-  globals::txd.txb.draw(glm::vec4{1.0f});
+  {
+    s2048::metrics::scoped_phase phase{globals::metrics, s2048::metrics::draw};
+    surge::gl_atom::sprite_database::draw(globals::sdb);
+    globals::txd.txb.draw(glm::vec4{1.0f});
+  }
 
   // Debug UI pass
 #ifdef SURGE_BUILD_TYPE_Debug
   s2048::debug_window::draw(w, globals::show_debug_window, globals::tdb, globals::sdb, globals::pd,
-                            globals::spc, globals::stq);
+                            globals::ad, globals::metrics,
+                            s2048::debug_window::capacities{sprite_capacity, glyph_capacity});
 #endif
 
   return 0;
 }
 
-extern "C" SURGE_MODULE_EXPORT auto gl_update(surge::window::window_t w, double) -> int {
-  using std::snprintf;
+// Advances the game by one fixed logic step
+static void step_game() noexcept {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::step_game");
+#endif
+
+  using namespace s2048;
+
+  // Buffered moves reach the logical board on the step they are read, whatever is still being
+  // animated. Moves that would not change the board, or come after the end, are dropped
+  while (!globals::inq.empty()) {
+    const auto d{globals::inq.front()};
+    globals::inq.pop_front();
+
+    if (!game_finished() && can_move(d)) {
+      play_move(d);
+    }
+  }
+
+  [[maybe_unused]] const auto caught_up{
+      animator::update(globals::ad, globals::pd, static_cast<float>(logic_step))};
+
+#ifdef SURGE_BUILD_TYPE_Debug
+  if (caught_up) {
+    check_animator();
+  }
+#endif
+}
+
+extern "C" SURGE_MODULE_EXPORT auto gl_update(surge::window::window_t w, double dt) -> int {
   using namespace surge;
   using namespace s2048;
   using namespace surge::gl_atom;
 
-  // Database resets
-  gl_atom::sprite_database::begin_add(globals::sdb);
-  globals::txd.txb.reset();
+  const auto frame_start{metrics::now()};
 
-  // Background Texture handles
-  static const auto bckg_handle{globals::tdb.find("resources/board.png").value_or(0)};
-
-  // Background model
+  // Background sprite, with the slots of the board size
   const auto dims{window::get_dims(w)};
-  const auto bckg_model{sprite_database::place_sprite(glm::vec2{0.0f}, dims, 0.1f)};
-  sprite_database::add(globals::sdb, bckg_handle, bckg_model);
+  const auto board_art{globals::board_size == 3 ? globals::board_3_handle : globals::board_handle};
+  sprite_layer::set(globals::spl, globals::spl.background,
+                    sprite_layer::sprite{board_art, glm::vec2{0.0f}, dims, 0.1f, 1.0f});
 
   // New Game button
   static ui::ui_state uist{-1, -1};
-  static const auto new_game_press_handle{
-      globals::tdb.find("resources/button_press.png").value_or(0)};
-  static const auto new_game_release_handle{
-      globals::tdb.find("resources/button_release.png").value_or(0)};
 
-  // New game bttn
-  ui::draw_data dd{glm::vec2{358.0f, 66.0f}, glm::vec2{138.0f, 40.0f}, 0.2f, 1.0f};
-  ui::button_skin skins{new_game_release_handle, new_game_release_handle, new_game_press_handle};
+  // New game bttn, below the score boxes of the board art
+  ui::draw_data dd{pieces::to_window(glm::vec2{358.0f, 66.0f}),
+                   pieces::to_window(glm::vec2{138.0f, 40.0f}), 0.2f, 1.0f};
+  ui::button_skin skins{globals::button_release_handle, globals::button_release_handle,
+                        globals::button_press_handle};
 
-  if (ui::button(w, __COUNTER__, uist, dd, globals::sdb, skins)) {
+  if (ui::button(w, __COUNTER__, uist, dd, globals::spl, globals::spl.button, skins)) {
     new_game();
   }
+  metrics::add_time(globals::metrics, metrics::ui, metrics::now() - frame_start);
 
-  // Current score value
-  std::array<char, 5> score_buffer{};
-  std::fill(score_buffer.begin(), score_buffer.end(), 0);
-  snprintf(score_buffer.data(), score_buffer.size(), "%u", globals::current_score);
-
-  globals::txd.txb.push_centered(glm::vec3{358.0f, 58.0f, 0.2f}, 0.25, glm::vec2{64.0f, 37.0f},
-                                 globals::txd.gc, score_buffer.data());
-
-  // Best score value
-  std::fill(score_buffer.begin(), score_buffer.end(), 0);
-  snprintf(score_buffer.data(), score_buffer.size(), "%u", globals::best_score);
-
-  globals::txd.txb.push_centered(glm::vec3{432.0f, 58.0f, 0.2f}, 0.25, glm::vec2{64.0f, 37.0f},
-                                 globals::txd.gc, score_buffer.data());
-
-  // Game states
-  static bool should_add_new_piece{false};
-
-  switch (globals::stq.front()) {
-
-  case game_state::compress_right:
-    if (pieces::idle(globals::pd)) {
-      pieces::compress_right(globals::pd, should_add_new_piece);
-      globals::stq.pop_front();
-    }
-    break;
+  // Game states, run at a fixed rate whatever the frame rate. Long stalls (breakpoints, window
+  // drags) are clamped so they do not turn into a burst of catch up steps
+  {
+    metrics::scoped_phase phase{globals::metrics, metrics::logic};
 
-  case game_state::merge_right:
-    if (pieces::idle(globals::pd)) {
-      pieces::merge_right(globals::pd, globals::spc, should_add_new_piece, globals::current_score);
-      globals::stq.pop_front();
+    globals::logic_time += std::min(dt, max_frame_time);
+    while (globals::logic_time >= logic_step) {
+      step_game();
+      globals::logic_time -= logic_step;
     }
-    break;
 
-  case game_state::compress_left:
-    if (pieces::idle(globals::pd)) {
-      pieces::compress_left(globals::pd, should_add_new_piece);
-      globals::stq.pop_front();
+    // Games are saved once their moves are shown, by a writer thread working on its own copy
+    if (globals::unsaved && animator::idle(globals::ad)) {
+      autosave::submit(globals::autosaver, snapshot());
+      globals::unsaved = false;
+      globals::metrics.current.saves++;
     }
-    break;
-
-  case game_state::merge_left:
-    if (pieces::idle(globals::pd)) {
-      pieces::merge_left(globals::pd, globals::spc, should_add_new_piece, globals::current_score);
-      globals::stq.pop_front();
-    }
-    break;
-
-  case game_state::compress_up:
-    if (pieces::idle(globals::pd)) {
-      pieces::compress_up(globals::pd, should_add_new_piece);
-      globals::stq.pop_front();
-    }
-    break;
-
-  case game_state::merge_up:
-    if (pieces::idle(globals::pd)) {
-      pieces::merge_up(globals::pd, globals::spc, should_add_new_piece, globals::current_score);
-      globals::stq.pop_front();
-    }
-    break;
-
-  case game_state::compress_down:
-    if (pieces::idle(globals::pd)) {
-      pieces::compress_down(globals::pd, should_add_new_piece);
-      globals::stq.pop_front();
-    }
-    break;
+  }
 
-  case game_state::merge_down:
-    if (pieces::idle(globals::pd)) {
-      pieces::merge_down(globals::pd, globals::spc, should_add_new_piece, globals::current_score);
-      globals::stq.pop_front();
-    }
-    break;
+  // The end of game message waits for the last move to be shown
+  const auto message{animator::idle(globals::ad)
+                         ? pieces::game_over(globals::board, globals::legal_moves,
+                                             globals::keep_playing)
+                         : nullptr};
+
+  // Text is shaped again only when a score or the message changed
+  {
+    metrics::scoped_phase phase{globals::metrics, metrics::text};
+    text_layer::set_number(globals::tl, globals::tl.current_score, globals::current_score);
+    text_layer::set_number(globals::tl, globals::tl.best_score, globals::best_score);
+    text_layer::set_message(globals::tl, message, dims);
+    text_layer::set_labels(globals::tl, globals::pd, pieces::tile_size());
+    globals::metrics.current.glyphs = text_layer::commit(globals::tl, globals::txd);
+  }
 
-  case game_state::piece_removal:
-    if (pieces::idle(globals::pd)) {
-      pieces::remove_stale(globals::spc, globals::pd);
-      pieces::update_exponents(globals::pd);
-      globals::stq.pop_front();
-    }
-    break;
-
-  case game_state::add_piece:
-    if (pieces::idle(globals::pd)) {
-      if (should_add_new_piece) {
-        pieces::create_random(globals::pd);
-        should_add_new_piece = false;
-      }
-      globals::stq.pop_front();
-    }
-    break;
+  // Sprites only reach the database when one of them changed
+  {
+    metrics::scoped_phase phase{globals::metrics, metrics::sprites};
+    sprite_layer::update_tiles(globals::spl, globals::tile_handles, globals::pd);
+    globals::metrics.current.sprites = sprite_layer::commit(globals::spl, globals::sdb);
+  }
 
-  case game_state::check_game_over:
-    if (pieces::idle(globals::pd)) {
-      if (!pieces::game_over(globals::pd, dims[0], dims[1], globals::txd)) {
-        globals::stq.pop_front();
-      }
-    }
-    break;
+  metrics::add_time(globals::metrics, metrics::frame, metrics::now() - frame_start);
 
-  default:
-    break;
-  }
+#ifdef SURGE_BUILD_TYPE_Debug
+  const auto allocations{alloc_counter::allocations()};
+  globals::metrics.current.allocations =
+      static_cast<surge::u32>(allocations - globals::allocations);
+  globals::allocations = allocations;
+#endif
 
-  // Update positions and add sprites to draw lists
-  pieces::update_positions(globals::pd);
-  pieces::add_sprites_to_database(globals::tdb, globals::sdb, globals::pd);
+  metrics::end_frame(globals::metrics);
 
   return 0;
 }
@@ -331,51 +703,56 @@ extern "C" SURGE_MODULE_EXPORT void gl_keyboard_event(surge::window::window_t, i
 
   using namespace s2048;
 
-  // Examine state stack. Only push a move if the board is idle
-  if (globals::stq.front() == game_state::idle) {
-    if (key == GLFW_KEY_RIGHT && action == GLFW_PRESS) {
-      globals::stq.pop_front();
-      globals::stq.push_back(game_state::compress_right);
-      globals::stq.push_back(game_state::merge_right);
-      globals::stq.push_back(game_state::piece_removal);
-      globals::stq.push_back(game_state::add_piece);
-      globals::stq.push_back(game_state::check_game_over);
-      globals::stq.push_back(game_state::idle);
-
-    } else if (key == GLFW_KEY_LEFT && action == GLFW_PRESS) {
-      globals::stq.pop_front();
-      globals::stq.push_back(game_state::compress_left);
-      globals::stq.push_back(game_state::merge_left);
-      globals::stq.push_back(game_state::piece_removal);
-      globals::stq.push_back(game_state::add_piece);
-      globals::stq.push_back(game_state::check_game_over);
-      globals::stq.push_back(game_state::idle);
-
-    } else if (key == GLFW_KEY_UP && action == GLFW_PRESS) {
-      globals::stq.pop_front();
-      globals::stq.push_back(game_state::compress_up);
-      globals::stq.push_back(game_state::merge_up);
-      globals::stq.push_back(game_state::piece_removal);
-      globals::stq.push_back(game_state::add_piece);
-      globals::stq.push_back(game_state::check_game_over);
-      globals::stq.push_back(game_state::idle);
-
-    } else if (key == GLFW_KEY_DOWN && action == GLFW_PRESS) {
-      globals::stq.pop_front();
-      globals::stq.push_back(game_state::compress_down);
-      globals::stq.push_back(game_state::merge_down);
-      globals::stq.push_back(game_state::piece_removal);
-      globals::stq.push_back(game_state::add_piece);
-      globals::stq.push_back(game_state::check_game_over);
-      globals::stq.push_back(game_state::idle);
+  // Arrows are buffered whatever the state, so no input is lost during animations. Once the
+  // buffer is full further presses are dropped
+  if (action == GLFW_PRESS && globals::inq.size() < max_buffered_moves) {
+    if (key == GLFW_KEY_UP) {
+      globals::inq.push_back(board::direction::up);
+    } else if (key == GLFW_KEY_DOWN) {
+      globals::inq.push_back(board::direction::down);
+    } else if (key == GLFW_KEY_LEFT) {
+      globals::inq.push_back(board::direction::left);
+    } else if (key == GLFW_KEY_RIGHT) {
+      globals::inq.push_back(board::direction::right);
     }
   }
 
+  // 3 and 4 start a new game on a board of that size
+  if ((key == GLFW_KEY_3 || key == GLFW_KEY_4) && action == GLFW_RELEASE) {
+    globals::board_size = key == GLFW_KEY_3 ? 3 : 4;
+    pieces::set_side(globals::board_size);
+    new_game();
+    log_info("New {}x{} game", globals::board_size, globals::board_size);
+  }
+
+  // Dismisses the win message, only the end of moves finishes the game from then on
+  if (key == GLFW_KEY_ENTER && action == GLFW_RELEASE && !globals::keep_playing
+      && board::max_exponent(globals::board) >= pieces::win_exponent) {
+    globals::keep_playing = true;
+    globals::unsaved = true;
+    log_info("Keep playing");
+  }
+
 #ifdef SURGE_BUILD_TYPE_Debug
   if (key == GLFW_KEY_F6 && action == GLFW_RELEASE) {
     globals::show_debug_window = !globals::show_debug_window;
     log_info("{} debug window", globals::show_debug_window ? "Showing" : "Hiding");
   }
+
+  if (key == GLFW_KEY_F7 && action == GLFW_RELEASE && globals::board_size != 4) {
+    log_info("Hint: the solver only plays 4x4 boards");
+  } else if (key == GLFW_KEY_F7 && action == GLFW_RELEASE) {
+    solver::config cfg{};
+    cfg.two_probability = globals::spawn_cfg.two_probability;
+
+    const auto hint{solver::search(globals::solver_ctx, globals::board, cfg)};
+    if (hint.has_move) {
+      constexpr const std::array<const char *, 4> names{"up", "down", "left", "right"};
+      log_info("Hint: move {} (depth {}, {} nodes)", names[hint.best], hint.depth, hint.nodes);
+    } else {
+      log_info("Hint: no moves left");
+    }
+  }
 #endif
 }
 
@@ -399,62 +776,29 @@ void s2048::new_game() {
 #endif
 
   // Clear all state
-  globals::pd.positions.clear();
-  globals::pd.current_values.clear();
-  globals::pd.target_values.clear();
-  globals::pd.current_slots.clear();
-  globals::pd.target_slots.clear();
-  globals::pd.ids.clear();
-  globals::stq.clear();
+  globals::board = 0;
+  globals::pd = pieces::pieces_data{};
+  globals::ad = animator::animator_data{};
+  globals::inq.clear();
 
   if (globals::current_score > globals::best_score) {
     globals::best_score = globals::current_score;
   }
 
   globals::current_score = 0;
+  globals::keep_playing = false;
   log_debug("Best score {}", globals::best_score);
 
-  // Reset piece ID queue
-  for (surge::u8 i = 0; i < 16; i++) {
-    globals::pd.ids.push_back(i);
-  }
-
-  // Init state stack
-  globals::stq.push_back(game_state::idle);
+  globals::record = save_game::save{};
+  globals::record.start_rng = globals::rng;
+  globals::unsaved = true;
 
-  pieces::create_random(globals::pd);
-  pieces::create_random(globals::pd);
-}
+  // Initial pieces
+  const auto size{globals::board_size};
+  board::track_list tracks{};
+  globals::board = spawner::spawn(globals::rng, globals::spawn_cfg, globals::board, tracks, size);
+  globals::board = spawner::spawn(globals::rng, globals::spawn_cfg, globals::board, tracks, size);
+  update_legal_moves();
 
-#ifdef SURGE_BUILD_TYPE_Debug
-auto s2048::state_to_str(game_state s) -> const char * {
-  switch (s) {
-  case idle:
-    return "idle";
-  case compress_up:
-    return "compress_up";
-  case compress_down:
-    return "compress_down";
-  case compress_left:
-    return "compress_left";
-  case compress_right:
-    return "compress_right";
-  case merge_up:
-    return "merge_up";
-  case merge_down:
-    return "merge_down";
-  case merge_left:
-    return "merge_left";
-  case merge_right:
-    return "merge_right";
-  case piece_removal:
-    return "piece_removal";
-  case add_piece:
-    return "add_piece";
-  case check_game_over:
-    return "check_game_over";
-  default:
-    return "unrecognized state";
-  }
+  animator::push(globals::ad, tracks);
 }
-#endif
\ No newline at end of file
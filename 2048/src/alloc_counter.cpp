@@ -0,0 +1,34 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace globals {
+
+static std::atomic<surge::u64> allocations{0}; // NOLINT
+
+} // namespace globals
+
+static auto counted_alloc(std::size_t size) -> void * {
+  globals::allocations.fetch_add(1, std::memory_order_relaxed);
+
+  // malloc(0) may return nullptr, which new must not
+  void *p{std::malloc(size != 0 ? size : 1)};
+  if (p == nullptr) {
+    throw std::bad_alloc{};
+  }
+  return p;
+}
+
+auto s2048::alloc_counter::allocations() noexcept -> surge::u64 {
+  return globals::allocations.load(std::memory_order_relaxed);
+}
+
+auto operator new(std::size_t size) -> void * { return counted_alloc(size); }
+auto operator new[](std::size_t size) -> void * { return counted_alloc(size); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
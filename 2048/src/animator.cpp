@@ -0,0 +1,108 @@
+#include "animator.hpp"
+
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+#  include <tracy/Tracy.hpp>
+#endif
+
+namespace {
+
+void start(s2048::animator::animator_data &ad, s2048::pieces::pieces_data &pd,
+           const s2048::board::track_list &tracks) noexcept {
+  using namespace s2048;
+
+  // IDs are looked up before any target changes, while slot_ids still matches the board
+  std::array<surge::u8, 17> ids{};
+  for (surge::u8 i = 0; i < tracks.size; i++) {
+    ids[i] = pd.slot_ids[tracks.tracks[i].from];
+  }
+
+  for (surge::u8 i = 0; i < tracks.size; i++) {
+    const auto &t{tracks.tracks[i]};
+    if (t.kind == board::track_kind::spawn || ids[i] == pieces::no_piece) {
+      continue;
+    }
+
+    pd.target_slots[ids[i]] = t.to;
+    if (t.kind == board::track_kind::merge) {
+      pd.target_exponents[ids[i]] = t.exponent;
+    }
+  }
+
+  // The piece a merge lands on is the other one ending at the same slot, moving or not
+  for (surge::u8 i = 0; i < tracks.size; i++) {
+    const auto &t{tracks.tracks[i]};
+    if (t.kind != board::track_kind::merge) {
+      continue;
+    }
+
+    pieces::for_each_piece(pd, [&](surge::u8 id) {
+      if (id != ids[i] && pd.target_slots[id] == t.to) {
+        pieces::mark_stale(ad.stale_pieces, id);
+      }
+    });
+  }
+}
+
+void finish(s2048::animator::animator_data &ad, s2048::pieces::pieces_data &pd,
+            const s2048::board::track_list &tracks) noexcept {
+  using namespace s2048;
+
+  pieces::remove_stale(ad.stale_pieces, pd);
+  pieces::update_exponents(pd);
+
+  // Merging pieces arrive together, so the slot may have been claimed by the consumed one
+  pieces::for_each_piece(pd, [&](surge::u8 id) { pd.slot_ids[pd.current_slots[id]] = id; });
+
+  for (surge::u8 i = 0; i < tracks.size; i++) {
+    const auto &t{tracks.tracks[i]};
+    if (t.kind == board::track_kind::spawn) {
+      pieces::create_piece(pd, t.exponent, t.to);
+    }
+  }
+}
+
+} // namespace
+
+void s2048::animator::push(animator_data &ad, const board::track_list &tracks) noexcept {
+  ad.pending.push_back(tracks);
+}
+
+auto s2048::animator::idle(const animator_data &ad) noexcept -> bool {
+  return ad.pending.empty();
+}
+
+auto s2048::animator::update(animator_data &ad, pieces::pieces_data &pd, float dt) noexcept
+    -> bool {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::animator::update");
+#endif
+
+  bool finished{false};
+
+  while (!ad.pending.empty()) {
+    if (!ad.playing) {
+      start(ad, pd, ad.pending.front());
+      ad.playing = true;
+    }
+
+    // With another move waiting, the slides of this one end at once
+    if (ad.pending.size() > 1) {
+      pieces::settle(pd);
+    } else {
+      pieces::update_positions(pd, dt);
+      dt = 0.0f;
+    }
+
+    if (!pieces::idle(pd)) {
+      break;
+    }
+
+    finish(ad, pd, ad.pending.front());
+    ad.pending.pop_front();
+    ad.playing = false;
+
+    finished = ad.pending.empty();
+  }
+
+  return finished;
+}
@@ -0,0 +1,82 @@
+#include "asset_pack.hpp"
+
+#include <cstring>
+
+namespace {
+
+// Larger than any texture GL implementations accept
+constexpr const surge::u32 max_dimension{65536};
+
+auto valid(const s2048::asset_pack::pack &p) noexcept -> bool {
+  using namespace s2048::asset_pack;
+
+  if (p.file.size < sizeof(header)) {
+    return false;
+  }
+
+  header h{};
+  std::memcpy(&h, p.file.data, sizeof(header));
+
+  if (h.magic != magic || h.version != version) {
+    return false;
+  }
+
+  const auto toc_end{sizeof(header) + surge::u64{h.entry_count} * sizeof(entry)};
+  if (toc_end > p.file.size) {
+    return false;
+  }
+
+  const auto entries{reinterpret_cast<const entry *>(p.file.data + sizeof(header))};
+  for (surge::u32 i = 0; i < h.entry_count; i++) {
+    const auto &e{entries[i]};
+
+    // Dimensions are bounded before the size product and the offset is checked against the file
+    // before the remaining size, so neither can wrap around
+    if (e.name.back() != '\0' || e.offset < toc_end || e.offset % data_alignment != 0
+        || e.width > max_dimension || e.height > max_dimension
+        || e.size != surge::u64{e.width} * e.height * 4 || e.offset > p.file.size
+        || e.size > p.file.size - e.offset) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+auto s2048::asset_pack::open(pack &p, const char *path) noexcept -> bool {
+  p = pack{};
+
+  if (!mapped_file::open(p.file, path)) {
+    return false;
+  }
+
+  if (!valid(p)) {
+    close(p);
+    return false;
+  }
+
+  header h{};
+  std::memcpy(&h, p.file.data, sizeof(header));
+
+  p.entries = reinterpret_cast<const entry *>(p.file.data + sizeof(header));
+  p.entry_count = h.entry_count;
+
+  return true;
+}
+
+void s2048::asset_pack::close(pack &p) noexcept {
+  mapped_file::close(p.file);
+  p = pack{};
+}
+
+auto s2048::asset_pack::find(const pack &p, const char *name) noexcept -> const entry * {
+  for (surge::u32 i = 0; i < p.entry_count; i++) {
+    if (std::strcmp(p.entries[i].name.data(), name) == 0) {
+      return &p.entries[i];
+    }
+  }
+
+  return nullptr;
+}
@@ -0,0 +1,65 @@
+#include "autosave.hpp"
+
+#include <cstdio>
+
+static void write_loop(s2048::autosave::autosaver &as) {
+  using namespace s2048;
+
+  std::unique_lock guard{as.lock};
+
+  while (true) {
+    as.wake.wait(guard, [&]() { return as.pending || as.stopping; });
+
+    if (!as.pending) {
+      return;
+    }
+
+    // The game keeps filling the other buffer while this one is written
+    const auto front{as.back};
+    as.back = static_cast<surge::u8>(1 - as.back);
+    as.pending = false;
+
+    guard.unlock();
+
+    if (!save_game::write(as.path.c_str(), as.buffers[front])) {
+      std::fprintf(stderr, "Unable to write the save file %s\n", as.path.c_str());
+    }
+
+    guard.lock();
+  }
+}
+
+void s2048::autosave::start(autosaver &as, const char *path) {
+  as.path = path;
+  as.pending = false;
+  as.stopping = false;
+  as.writer = std::thread{write_loop, std::ref(as)};
+}
+
+void s2048::autosave::submit(autosaver &as, const save_game::save &s) {
+  {
+    std::lock_guard guard{as.lock};
+
+    // Whole struct assignment, so no field is left behind. The move history is copied into the
+    // capacity the buffer already has, so steady state submits do not allocate.
+    as.buffers[as.back] = s;
+
+    as.pending = true;
+  }
+
+  as.wake.notify_one();
+}
+
+void s2048::autosave::stop(autosaver &as) {
+  if (!as.writer.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard guard{as.lock};
+    as.stopping = true;
+  }
+
+  as.wake.notify_one();
+  as.writer.join();
+}
@@ -0,0 +1,304 @@
+#include "board.hpp"
+
+#include <array>
+#include <bit>
+
+#if defined(__BMI2__)
+#  include <immintrin.h>
+#endif
+
+namespace {
+
+// Rows and columns are 16 bit words where nibble 0 is the cell touching the wall the pieces move
+// towards (left for rows, top for columns). Moves store the XOR between the input and the output,
+// so applying a move to a row is a single XOR into the board.
+struct row_tables {
+  std::array<s2048::board::row_t, 65536> left{};
+  std::array<s2048::board::row_t, 65536> right{};
+  std::array<s2048::board::board_t, 65536> up{};
+  std::array<s2048::board::board_t, 65536> down{};
+
+  // Up reuses the left scores, down reuses the right ones
+  std::array<surge::u32, 65536> score_left{};
+  std::array<surge::u32, 65536> score_right{};
+
+  // Bit 0 is set when moving towards nibble 0 changes the row, bit 1 when moving away does
+  std::array<surge::u8, 65536> changes{};
+};
+
+auto reverse_row(s2048::board::row_t row) noexcept -> s2048::board::row_t {
+  return static_cast<s2048::board::row_t>((row >> 12) | ((row >> 4) & 0x00F0)
+                                          | ((row << 4) & 0x0F00) | (row << 12));
+}
+
+auto unpack_column(s2048::board::row_t row) noexcept -> s2048::board::board_t {
+  const s2048::board::board_t c{row};
+  return (c | (c << 12) | (c << 24) | (c << 36)) & 0x000F000F000F000FULL;
+}
+
+/*
+ * Slides a row towards nibble 0 following the rules of the piece kernels: the row is compressed
+ * and then only the first pair of equal tiles, counting from the wall, is merged.
+ */
+auto slide_row(s2048::board::row_t row, surge::u32 &score) noexcept -> s2048::board::row_t {
+  std::array<surge::u8, 4> cells{0, 0, 0, 0};
+  surge::u8 size{0};
+
+  for (surge::u8 i = 0; i < 4; i++) {
+    const auto e{static_cast<surge::u8>((row >> (4 * i)) & 0xF)};
+    if (e != 0) {
+      cells[size] = e;
+      size++;
+    }
+  }
+
+  score = 0;
+
+  // A nibble can't hold the result of merging two 2^15 tiles, so those are left alone.
+  for (surge::u8 i = 0; i + 1 < size; i++) {
+    if (cells[i] == cells[i + 1] && cells[i] < 15) {
+      cells[i]++;
+      score = 1u << cells[i];
+
+      for (surge::u8 j = i + 1; j + 1 < size; j++) {
+        cells[j] = cells[j + 1];
+      }
+      cells[size - 1] = 0;
+      break;
+    }
+  }
+
+  return static_cast<s2048::board::row_t>(cells[0] | (cells[1] << 4) | (cells[2] << 8)
+                                          | (cells[3] << 12));
+}
+
+auto tables() noexcept -> const row_tables & {
+  static row_tables t{};
+
+  static const bool initialized{[]() {
+    for (surge::u32 i = 0; i < 65536; i++) {
+      const auto row{static_cast<s2048::board::row_t>(i)};
+      const auto rev{reverse_row(row)};
+
+      surge::u32 score{0};
+
+      const auto left{slide_row(row, score)};
+      t.left[i] = static_cast<s2048::board::row_t>(row ^ left);
+      t.up[i] = unpack_column(row) ^ unpack_column(left);
+      t.score_left[i] = score;
+
+      const auto right{reverse_row(slide_row(rev, score))};
+      t.right[i] = static_cast<s2048::board::row_t>(row ^ right);
+      t.down[i] = unpack_column(row) ^ unpack_column(right);
+      t.score_right[i] = score;
+
+      t.changes[i] = static_cast<surge::u8>((left != row ? 1u : 0u) | (right != row ? 2u : 0u));
+    }
+
+    return true;
+  }()};
+
+  static_cast<void>(initialized);
+  return t;
+}
+
+// select_in_byte[b][n] is the position of the n-th set bit of b
+constexpr const auto select_in_byte{[]() {
+  std::array<std::array<surge::u8, 8>, 256> t{};
+  for (surge::u32 b = 0; b < 256; b++) {
+    surge::u8 n{0};
+    for (surge::u8 bit = 0; bit < 8; bit++) {
+      if ((b & (1u << bit)) != 0) {
+        t[b][n] = bit;
+        n++;
+      }
+    }
+  }
+  return t;
+}()};
+
+} // namespace
+
+void s2048::board::init() noexcept {
+  static_cast<void>(tables());
+}
+
+auto s2048::board::get_exponent(board_t b, surge::u8 slot) noexcept -> surge::u8 {
+  return static_cast<surge::u8>((b >> (4 * slot)) & 0xF);
+}
+
+auto s2048::board::set_exponent(board_t b, surge::u8 slot, surge::u8 exponent) noexcept
+    -> board_t {
+  const auto shift{4 * slot};
+  return (b & ~(board_t{0xF} << shift)) | (board_t{exponent & 0xFu} << shift);
+}
+
+auto s2048::board::transpose(board_t b) noexcept -> board_t {
+  const auto a1{b & 0xF0F00F0FF0F00F0FULL};
+  const auto a2{b & 0x0000F0F00000F0F0ULL};
+  const auto a3{b & 0x0F0F00000F0F0000ULL};
+  const auto a{a1 | (a2 << 12) | (a3 >> 12)};
+
+  const auto b1{a & 0xFF00FF0000FF00FFULL};
+  const auto b2{a & 0x00FF00FF00000000ULL};
+  const auto b3{a & 0x00000000FF00FF00ULL};
+  return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+auto s2048::board::empty_mask(board_t b) noexcept -> surge::u16 {
+  // Fold each nibble onto its lowest bit, then gather those bits into the low 16 bits
+  auto x{b | (b >> 2)};
+  x = x | (x >> 1);
+  x = ~x & 0x1111111111111111ULL;
+
+  x = (x | (x >> 3)) & 0x0303030303030303ULL;
+  x = (x | (x >> 6)) & 0x000F000F000F000FULL;
+  x = (x | (x >> 12)) & 0x000000FF000000FFULL;
+  x = (x | (x >> 24)) & 0xFFFFULL;
+
+  return static_cast<surge::u16>(x);
+}
+
+auto s2048::board::select_slot(surge::u16 mask, surge::u8 n) noexcept -> surge::u8 {
+#if defined(__BMI2__)
+  return static_cast<surge::u8>(std::countr_zero(_pdep_u32(1u << n, mask)));
+#else
+  const auto low{static_cast<surge::u8>(mask & 0xFF)};
+  const auto low_count{static_cast<surge::u8>(std::popcount(low))};
+
+  if (n < low_count) {
+    return select_in_byte[low][n];
+  }
+
+  return static_cast<surge::u8>(8 + select_in_byte[mask >> 8][n - low_count]);
+#endif
+}
+
+auto s2048::board::move(board_t b, direction d) noexcept -> move_result {
+  const auto &t{tables()};
+
+  move_result result{b, 0, false};
+
+  switch (d) {
+  case direction::left:
+    for (surge::u8 i = 0; i < 4; i++) {
+      const auto row{static_cast<row_t>(b >> (16 * i))};
+      result.board ^= board_t{t.left[row]} << (16 * i);
+      result.score += t.score_left[row];
+    }
+    break;
+
+  case direction::right:
+    for (surge::u8 i = 0; i < 4; i++) {
+      const auto row{static_cast<row_t>(b >> (16 * i))};
+      result.board ^= board_t{t.right[row]} << (16 * i);
+      result.score += t.score_right[row];
+    }
+    break;
+
+  case direction::up: {
+    const auto tr{transpose(b)};
+    for (surge::u8 i = 0; i < 4; i++) {
+      const auto col{static_cast<row_t>(tr >> (16 * i))};
+      result.board ^= t.up[col] << (4 * i);
+      result.score += t.score_left[col];
+    }
+  } break;
+
+  case direction::down: {
+    const auto tr{transpose(b)};
+    for (surge::u8 i = 0; i < 4; i++) {
+      const auto col{static_cast<row_t>(tr >> (16 * i))};
+      result.board ^= t.down[col] << (4 * i);
+      result.score += t.score_right[col];
+    }
+  } break;
+
+  default:
+    break;
+  }
+
+  result.changed = result.board != b;
+  return result;
+}
+
+auto s2048::board::legal_moves(board_t b) noexcept -> surge::u8 {
+  const auto &t{tables()};
+  const auto tr{transpose(b)};
+
+  surge::u32 rows{0};
+  surge::u32 cols{0};
+
+  for (surge::u8 i = 0; i < 4; i++) {
+    rows |= t.changes[static_cast<row_t>(b >> (16 * i))];
+    cols |= t.changes[static_cast<row_t>(tr >> (16 * i))];
+  }
+
+  return static_cast<surge::u8>(((rows & 1u) != 0 ? move_bit(direction::left) : 0u)
+                                | ((rows & 2u) != 0 ? move_bit(direction::right) : 0u)
+                                | ((cols & 1u) != 0 ? move_bit(direction::up) : 0u)
+                                | ((cols & 2u) != 0 ? move_bit(direction::down) : 0u));
+}
+
+auto s2048::board::move(board_t b, direction d, track_list &tracks) noexcept -> move_result {
+  append_tracks(b, d, 4, tracks);
+  return move(b, d);
+}
+
+void s2048::board::append_tracks(board_t b, direction d, surge::u8 side,
+                                 track_list &tracks) noexcept {
+  for (surge::u8 i = 0; i < side; i++) {
+    std::array<surge::u8, 4> slots{};
+    std::array<surge::u8, 4> exponents{};
+    surge::u8 size{0};
+
+    for (surge::u8 k = 0; k < side; k++) {
+      const auto slot{line_slot(d, i, k, side)};
+      const auto e{get_exponent(b, slot)};
+      if (e != 0) {
+        slots[size] = slot;
+        exponents[size] = e;
+        size++;
+      }
+    }
+
+    // Same rule as slide_row: the first pair of equal tiles from the wall merges, the farther
+    // tile of the pair moving onto the nearer one
+    surge::u8 merging{size};
+    for (surge::u8 k = 0; k + 1 < size; k++) {
+      if (exponents[k] == exponents[k + 1] && exponents[k] < 15) {
+        merging = static_cast<surge::u8>(k + 1);
+        break;
+      }
+    }
+
+    for (surge::u8 k = 0; k < size; k++) {
+      const auto to{line_slot(d, i, static_cast<surge::u8>(k < merging ? k : k - 1), side)};
+
+      if (k == merging) {
+        tracks.tracks[tracks.size] = track{track_kind::merge, slots[k], to,
+                                           static_cast<surge::u8>(exponents[k] + 1)};
+        tracks.size++;
+      } else if (to != slots[k]) {
+        tracks.tracks[tracks.size] = track{track_kind::slide, slots[k], to, exponents[k]};
+        tracks.size++;
+      }
+    }
+  }
+}
+
+auto s2048::board::spawn(board_t b, surge::u8 slot, surge::u8 exponent,
+                         track_list &tracks) noexcept -> board_t {
+  tracks.tracks[tracks.size] = track{track_kind::spawn, slot, slot, exponent};
+  tracks.size++;
+  return set_exponent(b, slot, exponent);
+}
+
+auto s2048::board::max_exponent(board_t b) noexcept -> surge::u8 {
+  surge::u8 e{0};
+  for (surge::u8 slot = 0; slot < 16; slot++) {
+    const auto se{get_exponent(b, slot)};
+    e = se > e ? se : e;
+  }
+  return e;
+}
@@ -3,9 +3,14 @@
 #include "sc_opengl/atoms/imgui.hpp"
 #include "sc_window.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
 static void pd_window(bool *open, const s2048::pieces::pieces_data &pd) noexcept {
   using namespace surge;
   using namespace ImGui;
+  using s2048::pieces::for_each_piece;
 
   // Early out if the window is collapsed, as an optimization.
   if (!Begin("Pieces Data", open)) {
@@ -13,151 +18,110 @@ static void pd_window(bool *open, const s2048::pieces::pieces_data &pd) noexcept
     return;
   }
 
-  if (CollapsingHeader("Available IDs")) {
-    if (BeginTable("pd.ids_table", 2)) {
-      TableSetupColumn("Element");
+  if (CollapsingHeader("Live IDs")) {
+    Text("Occupancy mask: 0x%04x", pd.occupied);
+
+    if (BeginTable("pd.ids_table", 1)) {
       TableSetupColumn("ID");
       TableHeadersRow();
 
-      for (surge::usize i = 0; const auto &id : pd.ids) {
+      for_each_piece(pd, [](surge::u8 id) {
         TableNextRow();
         TableNextColumn();
 
-        Text("%lu", i);
-        TableNextColumn();
-
         Text("%u", id);
-        i++;
-      }
+      });
 
       EndTable();
     }
   }
 
   if (CollapsingHeader("Positions")) {
-    if (BeginTable("pd.ids_table", 3)) {
-      TableSetupColumn("Element");
+    if (BeginTable("pd.positions", 2)) {
       TableSetupColumn("ID");
       TableSetupColumn("Position");
       TableHeadersRow();
 
-      for (surge::usize i = 0; const auto &p : pd.positions) {
-        TableNextRow();
-        TableNextColumn();
-
-        Text("%lu", i);
-        TableNextColumn();
-
-        Text("%u", p.first);
-        TableNextColumn();
-
-        Text("(%.0f, %.0f)", p.second[0], p.second[1]);
-
-        i++;
-      }
-
-      EndTable();
-    }
-  }
-
-  if (CollapsingHeader("Current Values")) {
-    if (BeginTable("pd.current_values", 3)) {
-      TableSetupColumn("Element");
-      TableSetupColumn("ID");
-      TableSetupColumn("Current Value");
-      TableHeadersRow();
-
-      for (surge::usize i = 0; const auto &p : pd.current_values) {
+      for_each_piece(pd, [&](surge::u8 id) {
         TableNextRow();
         TableNextColumn();
 
-        Text("%lu", i);
-        TableNextColumn();
-
-        Text("%u", p.first);
+        Text("%u", id);
         TableNextColumn();
 
-        Text("%u", p.second);
-
-        i++;
-      }
+        Text("(%.0f, %.0f)", pd.positions[id][0], pd.positions[id][1]);
+      });
 
       EndTable();
     }
   }
 
-  if (CollapsingHeader("Target Values")) {
-    if (BeginTable("pd.target_values", 3)) {
-      TableSetupColumn("Element");
+  if (CollapsingHeader("Values")) {
+    if (BeginTable("pd.values", 3)) {
       TableSetupColumn("ID");
-      TableSetupColumn("Target Value");
+      TableSetupColumn("Current Exponent");
+      TableSetupColumn("Target Exponent");
       TableHeadersRow();
 
-      for (surge::usize i = 0; const auto &p : pd.target_values) {
+      for_each_piece(pd, [&](surge::u8 id) {
         TableNextRow();
         TableNextColumn();
 
-        Text("%lu", i);
+        Text("%u", id);
         TableNextColumn();
 
-        Text("%u", p.first);
+        Text("%u (%llu)", pd.current_exponents[id], 1ull << pd.current_exponents[id]);
         TableNextColumn();
 
-        Text("%u", p.second);
-
-        i++;
-      }
+        Text("%u (%llu)", pd.target_exponents[id], 1ull << pd.target_exponents[id]);
+      });
 
       EndTable();
     }
   }
 
-  if (CollapsingHeader("Current Slots")) {
-    if (BeginTable("pd.current_slots", 3)) {
-      TableSetupColumn("Element");
+  if (CollapsingHeader("Slots")) {
+    if (BeginTable("pd.slots", 3)) {
       TableSetupColumn("ID");
       TableSetupColumn("Current Slot");
+      TableSetupColumn("Target Slot");
       TableHeadersRow();
 
-      for (surge::usize i = 0; const auto &p : pd.current_slots) {
+      for_each_piece(pd, [&](surge::u8 id) {
         TableNextRow();
         TableNextColumn();
 
-        Text("%lu", i);
+        Text("%u", id);
         TableNextColumn();
 
-        Text("%u", p.first);
+        Text("%u", pd.current_slots[id]);
         TableNextColumn();
 
-        Text("%u", p.second);
-
-        i++;
-      }
+        Text("%u", pd.target_slots[id]);
+      });
 
       EndTable();
     }
   }
 
-  if (CollapsingHeader("Target Slots")) {
-    if (BeginTable("pd.target_slots", 3)) {
-      TableSetupColumn("Element");
+  if (CollapsingHeader("Slot Index")) {
+    if (BeginTable("pd.slot_ids", 2)) {
+      TableSetupColumn("Slot");
       TableSetupColumn("ID");
-      TableSetupColumn("Target Slot");
       TableHeadersRow();
 
-      for (surge::usize i = 0; const auto &p : pd.target_slots) {
+      for (surge::usize slot = 0; slot < pd.slot_ids.size(); slot++) {
         TableNextRow();
         TableNextColumn();
 
-        Text("%lu", i);
-        TableNextColumn();
-
-        Text("%u", p.first);
+        Text("%lu", slot);
         TableNextColumn();
 
-        Text("%u", p.second);
-
-        i++;
+        if (pd.slot_ids[slot] == s2048::pieces::no_piece) {
+          Text("-");
+        } else {
+          Text("%u", pd.slot_ids[slot]);
+        }
       }
 
       EndTable();
@@ -177,7 +141,9 @@ static void spc_window(bool *open, const s2048::pieces::piece_id_queue_t &spc) n
     return;
   }
 
-  if (BeginTable("spc_table", 2)) {
+  Text("Stale pieces: %lu", spc.size());
+
+  if (CollapsingHeader("Queue") && BeginTable("spc_table", 2)) {
     TableSetupColumn("Element");
     TableSetupColumn("Stale ID");
     TableHeadersRow();
@@ -200,33 +166,50 @@ static void spc_window(bool *open, const s2048::pieces::piece_id_queue_t &spc) n
   End();
 }
 
-static void stq_window(bool *open, const s2048::state_queue &stq) noexcept {
+static void tracks_window(bool *open, const s2048::animator::animator_data &ad) noexcept {
   using namespace surge;
   using namespace ImGui;
+  using s2048::board::track_kind;
 
   // Early out if the window is collapsed, as an optimization.
-  if (!Begin("State Queue", open)) {
+  if (!Begin("Animation Tracks", open)) {
     End();
     return;
   }
 
-  if (BeginTable("state_table", 3)) {
-    TableSetupColumn("Element");
-    TableSetupColumn("State ID");
-    TableSetupColumn("State Name");
+  Text("Pending moves: %lu (%s)", ad.pending.size(), ad.playing ? "playing" : "waiting");
+
+  if (CollapsingHeader("Tracks") && BeginTable("tracks_table", 5)) {
+    TableSetupColumn("Move");
+    TableSetupColumn("Kind");
+    TableSetupColumn("From");
+    TableSetupColumn("To");
+    TableSetupColumn("Exponent");
     TableHeadersRow();
 
-    for (surge::usize i = 0; const auto &id : stq) {
-      TableNextRow();
-      TableNextColumn();
+    for (surge::usize i = 0; const auto &tracks : ad.pending) {
+      for (surge::u8 j = 0; j < tracks.size; j++) {
+        const auto &t{tracks.tracks[j]};
 
-      Text("%lu", i);
-      TableNextColumn();
+        TableNextRow();
+        TableNextColumn();
 
-      Text("%u", id);
-      TableNextColumn();
+        Text("%lu", i);
+        TableNextColumn();
+
+        Text("%s", t.kind == track_kind::slide   ? "slide"
+                   : t.kind == track_kind::merge ? "merge"
+                                                 : "spawn");
+        TableNextColumn();
+
+        Text("%u", t.from);
+        TableNextColumn();
+
+        Text("%u", t.to);
+        TableNextColumn();
 
-      Text("%s", s2048::state_to_str(static_cast<s2048::game_state>(id)));
+        Text("%u", t.exponent);
+      }
 
       i++;
     }
@@ -237,10 +220,135 @@ static void stq_window(bool *open, const s2048::state_queue &stq) noexcept {
   End();
 }
 
+static void perf_window(bool *open, const s2048::metrics::recorder &mr,
+                        const s2048::debug_window::capacities &caps) noexcept {
+  using namespace surge;
+  using namespace ImGui;
+  using namespace s2048::metrics;
+
+  // Early out if the window is collapsed, as an optimization.
+  if (!Begin("Performance", open)) {
+    End();
+    return;
+  }
+
+  // Last 4 seconds at 60 Hz, walked only while this window is open
+  constexpr const surge::usize history{240};
+
+  const auto count{static_cast<surge::usize>(
+      std::min<surge::u64>(mr.written, std::min<surge::u64>(history, mr.capacity)))};
+
+  std::array<float, history> frame_ms{};
+  std::array<float, history> update_ms{};
+  std::array<float, history> draw_ms{};
+  std::array<float, history> allocations{};
+  std::array<float, phase_count> phase_us{};
+
+  // Buffers are only refilled on change, so their occupancy is the last non zero count seen
+  static surge::u32 sprites{0};
+  static surge::u32 glyphs{0};
+
+  surge::u32 moves{0};
+  surge::u64 move_ns{0};
+  surge::u32 saves{0};
+  float max_frame{0.0f};
+  float max_allocations{0.0f};
+  surge::u64 total_allocations{0};
+
+  for (surge::usize i = 0; i < count; i++) {
+    const auto &r{mr.records[(mr.written - count + i) % mr.capacity]};
+
+    update_ms[i] = static_cast<float>(r.phase_ns[phase::frame]) / 1.0e6f;
+    draw_ms[i] = static_cast<float>(r.phase_ns[phase::draw]) / 1.0e6f;
+    frame_ms[i] = update_ms[i] + draw_ms[i];
+    max_frame = std::max(max_frame, frame_ms[i]);
+
+    allocations[i] = static_cast<float>(r.allocations);
+    max_allocations = std::max(max_allocations, allocations[i]);
+    total_allocations += r.allocations;
+
+    for (surge::usize p = 0; p < phase_count; p++) {
+      phase_us[p] += static_cast<float>(r.phase_ns[p]) / 1.0e3f;
+    }
+
+    sprites = r.sprites != 0 ? r.sprites : sprites;
+    glyphs = r.glyphs != 0 ? r.glyphs : glyphs;
+    moves += r.moves;
+    move_ns += r.move_ns;
+    saves += r.saves;
+  }
+
+  if (count != 0) {
+    for (auto &us : phase_us) {
+      us /= static_cast<float>(count);
+    }
+  }
+
+  const auto frames{static_cast<int>(count)};
+
+  Text("Frames: %lu (showing %lu)", static_cast<unsigned long>(mr.written),
+       static_cast<unsigned long>(count));
+
+  if (CollapsingHeader("Frame time", ImGuiTreeNodeFlags_DefaultOpen)) {
+    Text("Update %.2f us, draw %.2f us on average, worst frame %.3f ms",
+         static_cast<double>(phase_us[phase::frame]), static_cast<double>(phase_us[phase::draw]),
+         static_cast<double>(max_frame));
+
+    const ImVec2 plot_size{0.0f, 48.0f};
+    PlotLines("Frame (ms)", frame_ms.data(), frames, 0, nullptr, 0.0f, max_frame, plot_size);
+    PlotLines("Update (ms)", update_ms.data(), frames, 0, nullptr, 0.0f, max_frame, plot_size);
+    PlotLines("Draw (ms)", draw_ms.data(), frames, 0, nullptr, 0.0f, max_frame, plot_size);
+  }
+
+  if (CollapsingHeader("Phases", ImGuiTreeNodeFlags_DefaultOpen)) {
+    // The whole frame is left out so the phases it contains keep a readable scale
+    const std::array<float, 5> parts{phase_us[phase::ui], phase_us[phase::logic],
+                                     phase_us[phase::text], phase_us[phase::sprites],
+                                     phase_us[phase::draw]};
+
+    PlotHistogram("Mean (us)", parts.data(), static_cast<int>(parts.size()), 0,
+                  "ui | logic | text | sprites | draw", 0.0f, *std::ranges::max_element(parts),
+                  ImVec2{0.0f, 80.0f});
+
+    Text("ui %.2f, logic %.2f, text %.2f, sprites %.2f, draw %.2f us",
+         static_cast<double>(parts[0]), static_cast<double>(parts[1]),
+         static_cast<double>(parts[2]), static_cast<double>(parts[3]),
+         static_cast<double>(parts[4]));
+
+    Text("Moves: %u (%.0f ns each), autosaves: %u", moves,
+         moves != 0 ? static_cast<double>(move_ns) / moves : 0.0, saves);
+  }
+
+  if (CollapsingHeader("Allocations", ImGuiTreeNodeFlags_DefaultOpen)) {
+    Text("%.2f per frame on average, at most %.0f",
+         count != 0 ? static_cast<double>(total_allocations) / static_cast<double>(count) : 0.0,
+         static_cast<double>(max_allocations));
+
+    // The scale never drops below one so frames without allocations sit on the axis
+    PlotHistogram("Per frame", allocations.data(), frames, 0, nullptr, 0.0f,
+                  std::max(max_allocations, 1.0f), ImVec2{0.0f, 48.0f});
+  }
+
+  if (CollapsingHeader("Buffers", ImGuiTreeNodeFlags_DefaultOpen)) {
+    std::array<char, 32> label{};
+
+    std::snprintf(label.data(), label.size(), "%u / %u sprites", sprites, caps.sprites);
+    ProgressBar(static_cast<float>(sprites) / static_cast<float>(caps.sprites),
+                ImVec2{-1.0f, 0.0f}, label.data());
+
+    std::snprintf(label.data(), label.size(), "%u / %u glyphs", glyphs, caps.glyphs);
+    ProgressBar(static_cast<float>(glyphs) / static_cast<float>(caps.glyphs),
+                ImVec2{-1.0f, 0.0f}, label.data());
+  }
+
+  End();
+}
+
 static void main_window(surge::window::window_t w, const s2048::tdb_t &tdb, const s2048::sdb_t &sdb,
                         const s2048::pieces::pieces_data &pd,
-                        const s2048::pieces::piece_id_queue_t &spc,
-                        const s2048::state_queue &stq) noexcept {
+                        const s2048::animator::animator_data &ad,
+                        const s2048::metrics::recorder &mr,
+                        const s2048::debug_window::capacities &caps) noexcept {
 
   using namespace surge;
   using namespace ImGui;
@@ -249,7 +357,8 @@ static void main_window(surge::window::window_t w, const s2048::tdb_t &tdb, cons
   static bool sdb_window_open{false};
   static bool pd_window_open{false};
   static bool spc_window_open{false};
-  static bool stq_window_open{false};
+  static bool tracks_window_open{false};
+  static bool perf_window_open{false};
 
   if (BeginMainMenuBar()) {
     if (BeginMenu("GPU Data")) {
@@ -273,14 +382,18 @@ static void main_window(surge::window::window_t w, const s2048::tdb_t &tdb, cons
         spc_window_open = true;
       }
 
-      if (MenuItem("State queue")) {
-        stq_window_open = true;
+      if (MenuItem("Animation tracks")) {
+        tracks_window_open = true;
       }
 
       ImGui::EndMenu();
     }
 
     if (BeginMenu("Module")) {
+      if (MenuItem("Performance")) {
+        perf_window_open = true;
+      }
+
       if (MenuItem("Quit")) {
         window::set_should_close(w, true);
       }
@@ -304,22 +417,26 @@ static void main_window(surge::window::window_t w, const s2048::tdb_t &tdb, cons
   }
 
   if (spc_window_open) {
-    spc_window(&spc_window_open, spc);
+    spc_window(&spc_window_open, ad.stale_pieces);
+  }
+
+  if (tracks_window_open) {
+    tracks_window(&tracks_window_open, ad);
   }
 
-  if (stq_window_open) {
-    stq_window(&stq_window_open, stq);
+  if (perf_window_open) {
+    perf_window(&perf_window_open, mr, caps);
   }
 }
 
 void s2048::debug_window::draw(surge::window::window_t w, bool &show, const tdb_t &tdb,
                                const sdb_t &sdb, const pieces::pieces_data &pd,
-                               const pieces::piece_id_queue_t &spc,
-                               const state_queue &stq) noexcept {
+                               const animator::animator_data &ad, const metrics::recorder &mr,
+                               const capacities &caps) noexcept {
   using namespace surge;
   if (show) {
     gl_atom::imgui::frame_begin();
-    main_window(w, tdb, sdb, pd, spc, stq);
+    main_window(w, tdb, sdb, pd, ad, mr, caps);
     gl_atom::imgui::frame_end();
   }
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "mapped_file.hpp"
+
+#include <cstdio>
+#include <string>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+auto s2048::mapped_file::open(mapping &m, const char *path) noexcept -> bool {
+  m = mapping{};
+
+#if defined(_WIN32)
+  const auto file{CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr)};
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  const auto map{CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+  if (map == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  const auto view{MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0)};
+  if (view == nullptr) {
+    CloseHandle(map);
+    CloseHandle(file);
+    return false;
+  }
+
+  m.file = file;
+  m.map = map;
+  m.data = static_cast<const std::byte *>(view);
+  m.size = static_cast<surge::u64>(size.QuadPart);
+  return true;
+#else
+  const auto fd{::open(path, O_RDONLY)};
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+
+  const auto size{static_cast<surge::usize>(st.st_size)};
+  // Shared, so writes made to the file by another process through a shared mapping show through
+  auto view{mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0)};
+
+  // The mapping keeps the file alive on its own
+  ::close(fd);
+
+  if (view == MAP_FAILED) {
+    return false;
+  }
+
+  // Mapped files are read whole right after being opened
+  madvise(view, size, MADV_WILLNEED);
+
+  m.data = static_cast<const std::byte *>(view);
+  m.size = static_cast<surge::u64>(size);
+  return true;
+#endif
+}
+
+auto s2048::mapped_file::create(mapping &m, const char *path, surge::u64 size) noexcept -> bool {
+  m = mapping{};
+
+#if defined(_WIN32)
+  // Windows does not let a mapped file shrink, so the mapping below only ever grows the file
+  const auto file{CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)};
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  const auto map{CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                    static_cast<DWORD>(size >> 32), static_cast<DWORD>(size),
+                                    nullptr)};
+  if (map == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  const auto view{MapViewOfFile(map, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size))};
+  if (view == nullptr) {
+    CloseHandle(map);
+    CloseHandle(file);
+    return false;
+  }
+
+  m.file = file;
+  m.map = map;
+#else
+  auto fd{::open(path, O_RDWR)};
+
+  struct stat st {};
+  if (fd >= 0 && (fstat(fd, &st) != 0 || static_cast<surge::u64>(st.st_size) != size)) {
+    ::close(fd);
+    fd = -1;
+  }
+
+  if (fd < 0) {
+    const std::string tmp_path{std::string{path} + ".tmp"};
+
+    fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 || std::rename(tmp_path.c_str(), path) != 0) {
+      ::close(fd);
+      ::unlink(tmp_path.c_str());
+      return false;
+    }
+  }
+
+  auto view{mmap(nullptr, static_cast<surge::usize>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                 0)};
+  ::close(fd);
+
+  if (view == MAP_FAILED) {
+    return false;
+  }
+#endif
+
+  m.writable_data = static_cast<std::byte *>(view);
+  m.data = m.writable_data;
+  m.size = size;
+  return true;
+}
+
+void s2048::mapped_file::close(mapping &m) noexcept {
+  if (m.data != nullptr) {
+#if defined(_WIN32)
+    UnmapViewOfFile(m.data);
+    CloseHandle(m.map);
+    CloseHandle(m.file);
+#else
+    munmap(const_cast<std::byte *>(m.data), static_cast<surge::usize>(m.size));
+#endif
+  }
+
+  m = mapping{};
+}
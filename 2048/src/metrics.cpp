@@ -0,0 +1,73 @@
+#include "metrics.hpp"
+
+#include <cstring>
+
+auto s2048::metrics::open(recorder &r, const char *path, surge::u32 capacity) noexcept -> bool {
+  r = recorder{};
+  r.capacity = capacity;
+
+  const auto size{sizeof(ring_header) + surge::u64{capacity} * sizeof(frame_record)};
+  if (!mapped_file::create(r.file, path, size)) {
+    r.fallback.resize(capacity);
+    r.records = r.fallback.data();
+    return false;
+  }
+
+  r.header = reinterpret_cast<ring_header *>(r.file.writable_data);
+  r.records = reinterpret_cast<frame_record *>(r.file.writable_data + sizeof(ring_header));
+
+  // A ring left by an earlier run or by the build before a hot reload goes on where it stopped,
+  // so readers following it keep their place
+  const auto &h{*r.header};
+  if (h.magic == magic && h.version == version && h.record_size == sizeof(frame_record)
+      && h.capacity == capacity) {
+    r.written = h.written.load(std::memory_order_acquire);
+    return true;
+  }
+
+  // Anything else is reset in place. Readers see written go back to 0 and start over.
+  r.header->magic = std::array<char, 4>{};
+  std::atomic_thread_fence(std::memory_order_release);
+
+  std::memset(static_cast<void *>(r.records), 0, capacity * sizeof(frame_record));
+  r.header->version = version;
+  r.header->record_size = sizeof(frame_record);
+  r.header->capacity = capacity;
+  r.header->written.store(0, std::memory_order_release);
+
+  // Written last, a reader seeing the magic sees the rest of the header
+  std::atomic_thread_fence(std::memory_order_release);
+  r.header->magic = magic;
+
+  return true;
+}
+
+void s2048::metrics::close(recorder &r) noexcept {
+  mapped_file::close(r.file);
+  r = recorder{};
+}
+
+void s2048::metrics::end_frame(recorder &r) noexcept {
+  if (r.capacity == 0) {
+    return;
+  }
+
+  r.current.frame = r.written;
+  r.current.time_ns = now();
+
+  r.records[r.written % r.capacity] = r.current;
+  r.written++;
+
+  if (r.header != nullptr) {
+    r.header->written.store(r.written, std::memory_order_release);
+  }
+
+  r.current = frame_record{};
+}
+
+auto s2048::metrics::last(const recorder &r) noexcept -> const frame_record * {
+  if (r.written == 0) {
+    return nullptr;
+  }
+  return &r.records[(r.written - 1) % r.capacity];
+}
@@ -0,0 +1,105 @@
+#include "packed_textures.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+#  include <tracy/Tracy.hpp>
+#endif
+
+auto s2048::packed_textures::upload(texture_set &ts, const asset_pack::pack &p) noexcept -> bool {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::packed_textures::upload");
+#endif
+
+  if (ts.size + p.entry_count > max_textures) {
+    log_error("Asset pack holds {} textures, at most {} fit", p.entry_count, max_textures);
+    return false;
+  }
+
+  for (surge::u32 i = 0; i < p.entry_count; i++) {
+    const auto &e{p.entries[i]};
+    if (!add(ts, e.name.data(), e.width, e.height, asset_pack::pixels(p, e))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+auto s2048::packed_textures::add(texture_set &ts, const char *name, surge::u32 width,
+                                 surge::u32 height, const void *pixels) noexcept -> bool {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::packed_textures::add");
+#endif
+
+  if (ts.size == max_textures) {
+    log_error("Unable to add {}, at most {} textures fit", name, max_textures);
+    return false;
+  }
+
+  const auto name_length{std::strlen(name)};
+  if (name_length >= ts.names[0].size()) {
+    log_error("Texture name {} is too long", name);
+    return false;
+  }
+
+  GLfloat max_anisotropy{1.0f};
+  glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy);
+
+  // Rows are tightly packed RGBA8
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  const auto levels{static_cast<GLsizei>(std::bit_width(std::max(width, height)))};
+
+  GLuint texture{0};
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+
+  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY, max_anisotropy);
+
+  glTextureStorage2D(texture, levels, GL_RGBA8, static_cast<GLsizei>(width),
+                     static_cast<GLsizei>(height));
+  glTextureSubImage2D(texture, 0, 0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                      GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  glGenerateTextureMipmap(texture);
+
+  const auto handle{glGetTextureHandleARB(texture)};
+  if (handle == 0) {
+    log_error("Unable to create a bindless handle for {}", name);
+    glDeleteTextures(1, &texture);
+    return false;
+  }
+  glMakeTextureHandleResidentARB(handle);
+
+  ts.names[ts.size] = {};
+  std::memcpy(ts.names[ts.size].data(), name, name_length);
+  ts.textures[ts.size] = texture;
+  ts.handles[ts.size] = handle;
+  ts.size++;
+
+  return true;
+}
+
+auto s2048::packed_textures::find(const texture_set &ts,
+                                  const char *name) noexcept -> std::optional<GLuint64> {
+  for (surge::u8 i = 0; i < ts.size; i++) {
+    if (std::strcmp(ts.names[i].data(), name) == 0) {
+      return ts.handles[i];
+    }
+  }
+
+  return {};
+}
+
+void s2048::packed_textures::destroy(texture_set &ts) noexcept {
+  for (surge::u8 i = 0; i < ts.size; i++) {
+    glMakeTextureHandleNonResidentARB(ts.handles[i]);
+  }
+
+  glDeleteTextures(static_cast<GLsizei>(ts.size), ts.textures.data());
+
+  ts = texture_set{};
+}
@@ -2,940 +2,185 @@
 
 #include <algorithm>
 #include <array>
-#include <random>
+#include <bit>
+#include <limits>
 
 #if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
 #  include <tracy/Tracy.hpp>
 #endif
 
-namespace globals {
-
-// clang-format off
-static const std::array<glm::vec2, 16> slot_coords {
-  glm::vec2{15.0f , 315.0f},
-  glm::vec2{136.0f, 315.0f},
-  glm::vec2{257.0f, 315.0f},
-  glm::vec2{378.0f, 315.0f},
+namespace {
 
-  glm::vec2{15.0f , 436.0f},
-  glm::vec2{136.0f, 436.0f},
-  glm::vec2{257.0f, 436.0f},
-  glm::vec2{378.0f, 436.0f},
+struct layout {
+  std::array<glm::vec2, s2048::pieces::max_pieces> slot_coords{};
+  glm::vec2 slot_delta{0.0f};
+  glm::vec2 tile{0.0f};
 
-  glm::vec2{15.0f , 557.0f},
-  glm::vec2{136.0f, 557.0f},
-  glm::vec2{257.0f, 557.0f},
-  glm::vec2{378.0f, 557.0f},
+  // Window over the 500x800 reference, per axis
+  glm::vec2 scale{1.0f};
 
-  glm::vec2{15.0f , 678.0f},
-  glm::vec2{136.0f, 678.0f},
-  glm::vec2{257.0f, 678.0f},
-  glm::vec2{378.0f, 678.0f}
+  glm::vec2 window_dims{0.0f};
+  surge::u8 side{4};
 };
-// clang-format on
-
-static const auto slot_delta{slot_coords[1][0] - slot_coords[0][0]};
-
-} // namespace globals
-
-auto s2048::pieces::create_piece(pieces_data &pd, surge::u16 value,
-                                 surge::u8 slot) noexcept -> surge::u8 {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::create_piece");
-#endif
-
-  // Gen ID
-  const auto id{pd.ids.front()};
-  pd.ids.pop_front();
-
-  // Store components
-  pd.positions[id] = globals::slot_coords[slot];
-
-  pd.current_values[id] = value;
-  pd.target_values[id] = value;
-
-  pd.current_slots[id] = slot;
-  pd.target_slots[id] = slot;
-
-  return id;
-}
-
-void s2048::pieces::delete_piece(pieces_data &pd, surge::u8 piece_id) noexcept {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::delete_piece");
-#endif
-
-  if (std::find(pd.ids.begin(), pd.ids.end(), piece_id) != pd.ids.end()) {
-    log_debug("Unable to remove piece id {} because it is already non existant", piece_id);
-  } else {
-    pd.positions.erase(piece_id);
-
-    pd.current_values.erase(piece_id);
-    pd.target_values.erase(piece_id);
 
-    pd.current_slots.erase(piece_id);
-    pd.target_slots.erase(piece_id);
-
-    pd.ids.push_back(piece_id);
+/*
+ * In the 500x800 reference, the slots span x in [15, 483] and start at y = 315, with 16 pixels
+ * between neighbouring pieces. Four slots per side give pieces of 105 pixels, 121 apart, and three
+ * give pieces of about 145 pixels, matching board_3.png.
+ */
+auto make_layout(glm::vec2 window_dims, surge::u8 side) noexcept -> layout {
+  const glm::vec2 reference{500.0f, 800.0f};
+  const glm::vec2 origin{15.0f, 315.0f};
+  constexpr const float span{468.0f};
+  constexpr const float gap{16.0f};
+
+  const auto scale{window_dims / reference};
+  const auto delta{(span + gap) / static_cast<float>(side)};
+
+  layout l{};
+  l.scale = scale;
+  l.window_dims = window_dims;
+  l.side = side;
+  l.slot_delta = delta * scale;
+  l.tile = glm::vec2{(delta - gap) * std::min(scale[0], scale[1])};
+
+  for (surge::u8 slot = 0; slot < s2048::pieces::max_pieces; slot++) {
+    const glm::vec2 cell{static_cast<float>(slot % side), static_cast<float>(slot / side)};
+    l.slot_coords[slot] = (origin + cell * delta) * scale;
   }
-}
 
-template <typename T, typename U>
-static auto has_value(const T value, const U &collection) -> bool {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::has_value");
-#endif
-
-  for (const auto &i : collection) {
-    if (i.second == value) {
-      return true;
-    }
-  }
-  return false;
+  return l;
 }
 
-auto s2048::pieces::create_random(pieces_data &pd) noexcept -> surge::u8 {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::create_random");
-#endif
-
-  log_debug("Adding random piece");
+} // namespace
 
-  const auto &slots{pd.current_slots};
-
-  if (slots.size() == 16) {
-    log_debug("pieces::create_random failed because the board is full. Returning piece ID 16");
-    return 16;
-  }
-
-  static std::minstd_rand engine{std::random_device{}()};
-  static std::uniform_int_distribution<unsigned short> slot_dist{0, 15};
-  static std::uniform_int_distribution<unsigned short> exp_dist{1, 2};
+namespace globals {
 
-  const auto random_value{static_cast<surge::u8>(1 << exp_dist(engine))};
+static layout current_layout{make_layout(glm::vec2{500.0f, 800.0f}, 4)}; // NOLINT
 
-  // Find free slot
-  auto random_slot{slot_dist(engine)};
+// Sliding speed, in slots per second
+static constexpr const float slide_speed{7.5f};
 
-  while (has_value(random_slot, slots)) {
-    random_slot = static_cast<surge::u8>(slot_dist(engine));
-  }
+} // namespace globals
 
-  return create_piece(pd, random_value, static_cast<surge::u8>(random_slot));
+void s2048::pieces::set_layout(glm::vec2 window_dims) noexcept {
+  globals::current_layout = make_layout(window_dims, globals::current_layout.side);
 }
 
-auto s2048::pieces::idle(const pieces_data &pd) noexcept -> bool {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::idle");
-#endif
-
-  auto &slots{pd.current_slots};
-  auto &target_slots{pd.target_slots};
-
-  for (const auto &[id, slot] : slots) {
-    if (slot != target_slots.at(id)) {
-      return false;
-    }
-  }
-
-  return true;
+void s2048::pieces::set_side(surge::u8 side) noexcept {
+  globals::current_layout = make_layout(globals::current_layout.window_dims, side);
 }
 
-auto s2048::pieces::game_over(const pieces_data &pd, float ww, float wh,
-                              txd_t &txd) noexcept -> bool {
-  // Reconstruct the board values in a 2D array
-  std::array<std::array<surge::u16, 4>, 4> board_values{
-      {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}}};
-
-  for (const auto &[id, slot] : pd.current_slots) {
-    const auto address{deflatten_slot(slot)};
-    board_values[address.row][address.col] = pd.current_values.at(id);
-  }
-
-  // Check if there is a 2048 piece
-  for (const auto r : board_values) {
-    for (const auto c : r) {
-      if (c == 2048) {
-        txd.txb.push_centered(glm::vec3{0.0f, wh, 0.3f}, 0.25, glm::vec2{ww, 500.0f}, txd.gc,
-                              "You Win!");
-        return true;
-      }
-    }
-  }
-
-  // If the board is full, are there any possible moves?
-  if (pd.current_slots.size() == 16) {
-    // Possible moves
-    std::array<bool, 24> possible_moves{
-        board_values[0][0] == board_values[0][1], board_values[0][0] == board_values[1][0],
-        board_values[0][1] == board_values[0][2], board_values[0][1] == board_values[1][1],
-        board_values[0][2] == board_values[0][3], board_values[0][2] == board_values[1][2],
-        board_values[0][3] == board_values[1][3], board_values[1][0] == board_values[1][1],
-        board_values[1][0] == board_values[2][0], board_values[1][1] == board_values[1][2],
-        board_values[1][1] == board_values[2][1], board_values[1][2] == board_values[1][3],
-        board_values[1][2] == board_values[2][2], board_values[1][3] == board_values[2][3],
-        board_values[2][0] == board_values[2][1], board_values[2][0] == board_values[3][0],
-        board_values[2][1] == board_values[2][2], board_values[2][1] == board_values[3][1],
-        board_values[2][2] == board_values[2][3], board_values[2][2] == board_values[3][2],
-        board_values[2][3] == board_values[3][3], board_values[3][0] == board_values[3][1],
-        board_values[3][1] == board_values[3][2], board_values[3][2] == board_values[3][3]};
-
-    if (!std::any_of(possible_moves.begin(), possible_moves.end(),
-                     [](const bool &b) { return b; })) {
-      txd.txb.push_centered(glm::vec3{0.0f, wh, 0.3f}, 0.25, glm::vec2{ww, 500.0f}, txd.gc,
-                            "Game Over!");
-      return true;
-    }
-  }
-
-  return false;
+auto s2048::pieces::tile_size() noexcept -> glm::vec2 {
+  return globals::current_layout.tile;
 }
 
-auto s2048::pieces::deflatten_slot(surge::u8 slot) noexcept -> board_address {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::deflatten_slot");
-#endif
-
-  switch (slot) {
-  case 0:
-    return board_address{0, 0};
-  case 1:
-    return board_address{0, 1};
-  case 2:
-    return board_address{0, 2};
-  case 3:
-    return board_address{0, 3};
-  case 4:
-    return board_address{1, 0};
-  case 5:
-    return board_address{1, 1};
-  case 6:
-    return board_address{1, 2};
-  case 7:
-    return board_address{1, 3};
-  case 8:
-    return board_address{2, 0};
-  case 9:
-    return board_address{2, 1};
-  case 10:
-    return board_address{2, 2};
-  case 11:
-    return board_address{2, 3};
-  case 12:
-    return board_address{3, 0};
-  case 13:
-    return board_address{3, 1};
-  case 14:
-    return board_address{3, 2};
-  case 15:
-    return board_address{3, 3};
-  default:
-    return board_address{16, 16};
-  }
+auto s2048::pieces::to_window(glm::vec2 reference) noexcept -> glm::vec2 {
+  return reference * globals::current_layout.scale;
 }
 
-auto s2048::pieces::get_element(const pieces_data &pd, board_element_type type,
-                                surge::u16 value) noexcept -> board_element {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::get_element");
-#endif
-
-  board_element element{{16, 16, 16, 16}, 0, board_element_configuration::OOOO};
-
-  // Get data and size
-  for (const auto &slot : pd.current_slots) {
-    const auto slot_coords{deflatten_slot(slot.second)};
-
-    if (type == board_element_type::row && slot_coords.row == value) {
-      element.data.at(slot_coords.col) = slot.first;
-      element.size += 1;
-
-    } else if (type == board_element_type::column && slot_coords.col == value) {
-      element.data.at(slot_coords.row) = slot.first;
-      element.size += 1;
-    }
-  }
-
-  // Get get configuration
-  if (element.size == 0) {
-    return element;
-  } else if (element.size == 1) {
-    if (element.data[0] != 16) {
-      element.config = board_element_configuration::XOOO;
-    } else if (element.data[1] != 16) {
-      element.config = board_element_configuration::OXOO;
-    } else if (element.data[2] != 16) {
-      element.config = board_element_configuration::OOXO;
-    } else {
-      element.config = board_element_configuration::OOOX;
-    }
-  } else if (element.size == 4) {
-    element.config = board_element_configuration::XXXX;
-  } else if (element.size == 3) {
-    if (element.data[0] != 16 && element.data[1] != 16 && element.data[2] != 16) {
-      element.config = board_element_configuration::XXXO;
-    } else if (element.data[0] != 16 && element.data[1] != 16 && element.data[3] != 16) {
-      element.config = board_element_configuration::XXOX;
-    } else if (element.data[0] != 16 && element.data[2] != 16 && element.data[3] != 16) {
-      element.config = board_element_configuration::XOXX;
-    } else {
-      element.config = board_element_configuration::OXXX;
-    }
-  } else if (element.size == 2) {
-    if (element.data[0] != 16 && element.data[1] != 16) {
-      element.config = board_element_configuration::XXOO;
-    } else if (element.data[0] != 16 && element.data[2] != 16) {
-      element.config = board_element_configuration::XOXO;
-    } else if (element.data[0] != 16 && element.data[3] != 16) {
-      element.config = board_element_configuration::XOOX;
-    } else if (element.data[1] != 16 && element.data[2] != 16) {
-      element.config = board_element_configuration::OXXO;
-    } else if (element.data[1] != 16 && element.data[3] != 16) {
-      element.config = board_element_configuration::OXOX;
-    } else {
-      element.config = board_element_configuration::OOXX;
-    }
-  }
-
-  return element;
-}
-
-void s2048::pieces::compress_right(pieces_data &pd, bool &should_add_new_piece) noexcept {
+auto s2048::pieces::create_piece(pieces_data &pd, surge::u8 exponent,
+                                 surge::u8 slot) noexcept -> surge::u8 {
 #if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::compress_right");
+  ZoneScopedN("s2048::pieces::create_piece");
 #endif
 
-  log_debug("Compressing right");
-
-  auto &target_slots{pd.target_slots};
-
-  for (surge::u8 i = 0; i < 4; i++) {
-    const auto element{get_element(pd, board_element_type::row, i)};
-
-    switch (element.config) {
-    case board_element_configuration::XOOO:
-      target_slots[element.data[0]] = 3 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXOO:
-      target_slots[element.data[1]] = 3 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OOXO:
-      target_slots[element.data[2]] = 3 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XXOO:
-      target_slots[element.data[0]] = 2 + i * 4;
-      target_slots[element.data[1]] = 3 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOXO:
-      target_slots[element.data[0]] = 2 + i * 4;
-      target_slots[element.data[2]] = 3 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOOX:
-      target_slots[element.data[0]] = 2 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXXO:
-      target_slots[element.data[1]] = 2 + i * 4;
-      target_slots[element.data[2]] = 3 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXOX:
-      target_slots[element.data[1]] = 2 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XXXO:
-      target_slots[element.data[0]] = 1 + i * 4;
-      target_slots[element.data[1]] = 2 + i * 4;
-      target_slots[element.data[2]] = 3 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XXOX:
-      target_slots[element.data[0]] = 1 + i * 4;
-      target_slots[element.data[1]] = 2 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOXX:
-      target_slots[element.data[0]] = 1 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    default:
-      break;
-    }
+  // Gen ID
+  const auto id{static_cast<surge::u8>(std::countr_one(pd.occupied))};
+  if (id >= max_pieces) {
+    log_debug("Unable to create piece because all IDs are in use");
+    return no_piece;
   }
-}
 
-void s2048::pieces::merge_right(pieces_data &pd, piece_id_queue_t &stale_pieces,
-                                bool &should_add_new_piece, surge::u32 &game_score) noexcept {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::merge_right");
-#endif
-
-  log_debug("Merging right");
-
-  surge::u16 round_points{0};
-
-  auto &target_slots{pd.target_slots};
-  auto &values{pd.current_values};
-  auto &target_values{pd.target_values};
-
-  for (surge::u8 i = 0; i < 4; i++) {
-    const auto element{get_element(pd, board_element_type::row, i)};
+  pd.occupied = static_cast<surge::u16>(pd.occupied | (1u << id));
+  pd.slot_ids[slot] = id;
 
-    switch (element.config) {
-
-    case board_element_configuration::OOXX:
-      if (values[element.data[2]] == values[element.data[3]]) {
-        target_slots[element.data[2]] = 3 + i * 4;
-        target_values[element.data[2]] *= 2;
-        round_points += target_values[element.data[2]];
-        mark_stale(stale_pieces, element.data[3]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    case board_element_configuration::OXXX:
-      if (values[element.data[2]] == values[element.data[3]]) {
-        target_slots[element.data[1]] = 2 + i * 4;
-        target_slots[element.data[2]] = 3 + i * 4;
-        target_values[element.data[2]] *= 2;
-        round_points += target_values[element.data[2]];
-        mark_stale(stale_pieces, element.data[3]);
-        should_add_new_piece = true;
-      } else if (values[element.data[1]] == values[element.data[2]]) {
-        target_slots[element.data[1]] = 2 + i * 4;
-        target_values[element.data[1]] *= 2;
-        round_points += target_values[element.data[1]];
-        mark_stale(stale_pieces, element.data[2]);
-        should_add_new_piece = true;
-      }
-      break;
+  // Store components
+  pd.positions[id] = globals::current_layout.slot_coords[slot];
 
-    case board_element_configuration::XXXX:
-      if (values[element.data[2]] == values[element.data[3]]) {
-        target_slots[element.data[0]] = 1 + i * 4;
-        target_slots[element.data[1]] = 2 + i * 4;
-        target_slots[element.data[2]] = 3 + i * 4;
-        target_values[element.data[2]] *= 2;
-        round_points += target_values[element.data[2]];
-        mark_stale(stale_pieces, element.data[3]);
-        should_add_new_piece = true;
-      } else if (values[element.data[1]] == values[element.data[2]]) {
-        target_slots[element.data[0]] = 1 + i * 4;
-        target_slots[element.data[1]] = 2 + i * 4;
-        target_values[element.data[1]] *= 2;
-        round_points += target_values[element.data[1]];
-        mark_stale(stale_pieces, element.data[2]);
-        should_add_new_piece = true;
-      } else if (values[element.data[0]] == values[element.data[1]]) {
-        target_slots[element.data[0]] = 1 + i * 4;
-        target_values[element.data[0]] *= 2;
-        round_points += target_values[element.data[0]];
-        mark_stale(stale_pieces, element.data[1]);
-        should_add_new_piece = true;
-      }
-      break;
+  pd.current_exponents[id] = exponent;
+  pd.target_exponents[id] = exponent;
 
-    default:
-      break;
-    }
-  }
+  pd.current_slots[id] = slot;
+  pd.target_slots[id] = slot;
 
-  game_score += round_points;
+  return id;
 }
 
-void s2048::pieces::compress_left(pieces_data &pd, bool &should_add_new_piece) noexcept {
+void s2048::pieces::delete_piece(pieces_data &pd, surge::u8 piece_id) noexcept {
 #if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::compress_left");
+  ZoneScopedN("s2048::pieces::delete_piece");
 #endif
 
-  log_debug("Compressing left");
-
-  auto &target_slots{pd.target_slots};
-
-  for (surge::u8 i = 0; i < 4; i++) {
-    const auto element{get_element(pd, board_element_type::row, i)};
-
-    switch (element.config) {
-    case board_element_configuration::OXOO:
-      target_slots[element.data[1]] = i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OOXO:
-      target_slots[element.data[2]] = i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OOOX:
-      target_slots[element.data[3]] = i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOXO:
-      target_slots[element.data[2]] = 1 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOOX:
-      target_slots[element.data[3]] = 1 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXXO:
-      target_slots[element.data[1]] = i * 4;
-      target_slots[element.data[2]] = 1 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXOX:
-      target_slots[element.data[1]] = i * 4;
-      target_slots[element.data[3]] = 1 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OOXX:
-      target_slots[element.data[2]] = i * 4;
-      target_slots[element.data[3]] = 1 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XXOX:
-      target_slots[element.data[3]] = 2 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOXX:
-      target_slots[element.data[2]] = 1 + i * 4;
-      target_slots[element.data[3]] = 2 + i * 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXXX:
-      target_slots[element.data[1]] = 0 + i * 4;
-      target_slots[element.data[2]] = 1 + i * 4;
-      target_slots[element.data[3]] = 2 + i * 4;
-      should_add_new_piece = true;
-      break;
+  if (piece_id >= max_pieces || (pd.occupied & (1u << piece_id)) == 0) {
+    log_debug("Unable to remove piece id {} because it is already non existant", piece_id);
+  } else {
+    pd.occupied = static_cast<surge::u16>(pd.occupied & ~(1u << piece_id));
 
-    default:
-      break;
+    // A piece merged into this one may already be resting on the same slot
+    const auto slot{pd.current_slots[piece_id]};
+    if (pd.slot_ids[slot] == piece_id) {
+      pd.slot_ids[slot] = no_piece;
     }
   }
 }
 
-void s2048::pieces::merge_left(pieces_data &pd, piece_id_queue_t &stale_pieces,
-                               bool &should_add_new_piece, surge::u32 &game_score) noexcept {
+auto s2048::pieces::idle(const pieces_data &pd) noexcept -> bool {
 #if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::merge_left");
+  ZoneScopedN("s2048::pieces::idle");
 #endif
 
-  log_debug("Merging left");
-
-  surge::u16 round_points{0};
-
-  auto &target_slots{pd.target_slots};
-  auto &values{pd.current_values};
-  auto &target_values{pd.target_values};
-
-  for (surge::u8 i = 0; i < 4; i++) {
-    const auto element{get_element(pd, board_element_type::row, i)};
-
-    switch (element.config) {
-
-    case board_element_configuration::XXOO:
-      if (values[element.data[0]] == values[element.data[1]]) {
-        target_slots[element.data[1]] = i * 4;
-        target_values[element.data[1]] *= 2;
-        round_points += target_values[element.data[1]];
-        mark_stale(stale_pieces, element.data[0]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    case board_element_configuration::XXXO:
-      if (values[element.data[0]] == values[element.data[1]]) {
-        target_slots[element.data[1]] = i * 4;
-        target_slots[element.data[2]] = 1 + i * 4;
-        target_values[element.data[1]] *= 2;
-        round_points += target_values[element.data[1]];
-        mark_stale(stale_pieces, element.data[0]);
-        should_add_new_piece = true;
-      } else if (values[element.data[1]] == values[element.data[2]]) {
-        target_slots[element.data[2]] = 1 + i * 4;
-        target_values[element.data[2]] *= 2;
-        round_points += target_values[element.data[2]];
-        mark_stale(stale_pieces, element.data[1]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    case board_element_configuration::XXXX:
-      if (values[element.data[0]] == values[element.data[1]]) {
-        target_slots[element.data[1]] = i * 4;
-        target_slots[element.data[2]] = 1 + i * 4;
-        target_slots[element.data[3]] = 2 + i * 4;
-        target_values[element.data[1]] *= 2;
-        round_points += target_values[element.data[1]];
-        mark_stale(stale_pieces, element.data[0]);
-        should_add_new_piece = true;
-      } else if (values[element.data[1]] == values[element.data[2]]) {
-        target_slots[element.data[2]] = 1 + i * 4;
-        target_slots[element.data[3]] = 2 + i * 4;
-        target_values[element.data[2]] *= 2;
-        round_points += target_values[element.data[2]];
-        mark_stale(stale_pieces, element.data[1]);
-        should_add_new_piece = true;
-      } else if (values[element.data[2]] == values[element.data[3]]) {
-        target_slots[element.data[3]] = 2 + i * 4;
-        target_values[element.data[3]] *= 2;
-        round_points += target_values[element.data[3]];
-        mark_stale(stale_pieces, element.data[2]);
-        should_add_new_piece = true;
-      }
-      break;
+  bool idle{true};
 
-    default:
-      break;
-    }
-  }
+  for_each_piece(pd, [&](surge::u8 id) {
+    idle = idle && pd.current_slots[id] == pd.target_slots[id];
+  });
 
-  game_score += round_points;
+  return idle;
 }
 
-void s2048::pieces::compress_up(pieces_data &pd, bool &should_add_new_piece) noexcept {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::compress_up");
-#endif
-
-  log_debug("Compressing up");
-
-  auto &target_slots{pd.target_slots};
-
-  for (surge::u8 i = 0; i < 4; i++) {
-    const auto element{get_element(pd, board_element_type::column, i)};
-
-    switch (element.config) {
-
-    case board_element_configuration::OXOO:
-      target_slots[element.data[1]] = i;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OOXO:
-      target_slots[element.data[2]] = i;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OOOX:
-      target_slots[element.data[3]] = i;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOXO:
-      target_slots[element.data[2]] = i + 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOOX:
-      target_slots[element.data[3]] = i + 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXXO:
-      target_slots[element.data[1]] = i;
-      target_slots[element.data[2]] = i + 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXOX:
-      target_slots[element.data[1]] = i;
-      target_slots[element.data[3]] = i + 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OOXX:
-      target_slots[element.data[2]] = i;
-      target_slots[element.data[3]] = i + 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XXOX:
-      target_slots[element.data[3]] = i + 4 * 2;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOXX:
-      target_slots[element.data[2]] = i + 4;
-      target_slots[element.data[3]] = i + 4 * 2;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXXX:
-      target_slots[element.data[1]] = i;
-      target_slots[element.data[2]] = i + 4;
-      target_slots[element.data[3]] = i + 4 * 2;
-      should_add_new_piece = true;
-      break;
-
-    default:
-      break;
-    }
+auto s2048::pieces::game_over(board::board_t b, surge::u8 legal_moves,
+                              bool keep_playing) noexcept -> const char * {
+  // Check if there is a 2048 piece
+  if (!keep_playing && board::max_exponent(b) >= win_exponent) {
+    return "You Win! Enter keeps playing";
   }
-}
-
-void s2048::pieces::merge_up(pieces_data &pd, piece_id_queue_t &stale_pieces,
-                             bool &should_add_new_piece, surge::u32 &game_score) noexcept {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::merge_up");
-#endif
-
-  log_debug("Merging up");
-
-  surge::u16 round_points{0};
 
-  auto &target_slots{pd.target_slots};
-  auto &values{pd.current_values};
-  auto &target_values{pd.target_values};
-
-  for (surge::u8 i = 0; i < 4; i++) {
-    const auto element{get_element(pd, board_element_type::column, i)};
-
-    switch (element.config) {
-
-    case board_element_configuration::XXOO:
-      if (values[element.data[0]] == values[element.data[1]]) {
-        target_slots[element.data[1]] = i;
-        target_values[element.data[1]] *= 2;
-        round_points += target_values[element.data[1]];
-        mark_stale(stale_pieces, element.data[0]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    case board_element_configuration::XXXO:
-      if (values[element.data[0]] == values[element.data[1]]) {
-        target_slots[element.data[1]] = i;
-        target_slots[element.data[2]] = i + 4;
-        target_values[element.data[1]] += 1;
-        round_points += target_values[element.data[1]];
-        mark_stale(stale_pieces, element.data[0]);
-        should_add_new_piece = true;
-      } else if (values[element.data[1]] == values[element.data[2]]) {
-        target_slots[element.data[2]] = i + 4;
-        target_values[element.data[2]] *= 2;
-        round_points += target_values[element.data[2]];
-        mark_stale(stale_pieces, element.data[1]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    case board_element_configuration::XXXX:
-      if (values[element.data[0]] == values[element.data[1]]) {
-        target_slots[element.data[1]] = i;
-        target_slots[element.data[2]] = i + 4;
-        target_slots[element.data[3]] = i + 4 * 2;
-        target_values[element.data[1]] *= 2;
-        round_points += target_values[element.data[1]];
-        mark_stale(stale_pieces, element.data[0]);
-        should_add_new_piece = true;
-      } else if (values[element.data[1]] == values[element.data[2]]) {
-        target_slots[element.data[2]] = i + 4;
-        target_slots[element.data[3]] = i + 4 * 2;
-        target_values[element.data[2]] *= 2;
-        round_points += target_values[element.data[2]];
-        mark_stale(stale_pieces, element.data[1]);
-        should_add_new_piece = true;
-      } else if (values[element.data[2]] == values[element.data[3]]) {
-        target_slots[element.data[3]] = i + 4 * 2;
-        target_values[element.data[3]] *= 2;
-        round_points += target_values[element.data[3]];
-        mark_stale(stale_pieces, element.data[2]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    default:
-      break;
-    }
+  // No move changes the board
+  if (legal_moves == 0) {
+    return "Game Over!";
   }
 
-  game_score += round_points;
+  return nullptr;
 }
 
-void s2048::pieces::compress_down(pieces_data &pd, bool &should_add_new_piece) noexcept {
+auto s2048::pieces::to_board(const pieces_data &pd) noexcept -> board::board_t {
 #if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::compress_down");
+  ZoneScopedN("s2048::pieces::to_board");
 #endif
 
-  log_debug("Compressing down");
-
-  auto &target_slots{pd.target_slots};
-
-  for (surge::u8 i = 0; i < 4; i++) {
-    const auto element{get_element(pd, board_element_type::column, i)};
-
-    switch (element.config) {
-
-    case board_element_configuration::XOOO:
-      target_slots[element.data[0]] = i + 4 * 3;
-      should_add_new_piece = true;
-      break;
+  board::board_t b{0};
 
-    case board_element_configuration::OXOO:
-      target_slots[element.data[1]] = i + 4 * 3;
-      should_add_new_piece = true;
-      break;
+  for_each_piece(pd, [&](surge::u8 id) {
+    b = board::set_exponent(b, pd.current_slots[id], pd.current_exponents[id]);
+  });
 
-    case board_element_configuration::OOXO:
-      target_slots[element.data[2]] = i + 4 * 3;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXOX:
-      target_slots[element.data[1]] = i + 4 * 2;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOOX:
-      target_slots[element.data[0]] = i + 4 * 2;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::OXXO:
-      target_slots[element.data[1]] = i + 4 * 2;
-      target_slots[element.data[2]] = i + 4 * 3;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XXOO:
-      target_slots[element.data[0]] = i + 4 * 2;
-      target_slots[element.data[1]] = i + 4 * 3;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOXO:
-      target_slots[element.data[0]] = i + 4 * 2;
-      target_slots[element.data[2]] = i + 4 * 3;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XOXX:
-      target_slots[element.data[0]] = i + 4;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XXOX:
-      target_slots[element.data[0]] = i + 4;
-      target_slots[element.data[1]] = i + 4 * 2;
-      should_add_new_piece = true;
-      break;
-
-    case board_element_configuration::XXXO:
-      target_slots[element.data[0]] = i + 4;
-      target_slots[element.data[1]] = i + 4 * 2;
-      target_slots[element.data[2]] = i + 4 * 3;
-      should_add_new_piece = true;
-      break;
-
-    default:
-      break;
-    }
-  }
+  return b;
 }
 
-void s2048::pieces::merge_down(pieces_data &pd, piece_id_queue_t &stale_pieces,
-                               bool &should_add_new_piece, surge::u32 &game_score) noexcept {
+void s2048::pieces::from_board(pieces_data &pd, board::board_t b) noexcept {
 #if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("mod_2048::pieces::merge_down");
+  ZoneScopedN("s2048::pieces::from_board");
 #endif
 
-  log_debug("Merging down");
-
-  surge::u16 round_points{0};
-
-  auto &target_slots{pd.target_slots};
-  auto &exponents{pd.current_values};
-  auto &target_exponents{pd.target_values};
-
-  for (surge::u8 i = 0; i < 4; i++) {
-    const auto element{get_element(pd, board_element_type::column, i)};
+  pd = pieces_data{};
 
-    switch (element.config) {
-
-    case board_element_configuration::OOXX:
-      if (exponents[element.data[2]] == exponents[element.data[3]]) {
-        target_slots[element.data[2]] = i + 4 * 3;
-        target_exponents[element.data[2]] *= 2;
-        round_points += target_exponents[element.data[2]];
-        mark_stale(stale_pieces, element.data[3]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    case board_element_configuration::OXXX:
-      if (exponents[element.data[2]] == exponents[element.data[3]]) {
-        target_slots[element.data[1]] = i + 4 * 2;
-        target_slots[element.data[2]] = i + 4 * 3;
-        target_exponents[element.data[2]] *= 2;
-        round_points += target_exponents[element.data[2]];
-        mark_stale(stale_pieces, element.data[3]);
-        should_add_new_piece = true;
-      } else if (exponents[element.data[1]] == exponents[element.data[2]]) {
-        target_slots[element.data[1]] = i + 4 * 2;
-        target_exponents[element.data[1]] *= 2;
-        round_points += target_exponents[element.data[1]];
-        mark_stale(stale_pieces, element.data[2]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    case board_element_configuration::XXXX:
-      if (exponents[element.data[2]] == exponents[element.data[3]]) {
-        target_slots[element.data[0]] = i + 4;
-        target_slots[element.data[1]] = i + 4 * 2;
-        target_slots[element.data[2]] = i + 4 * 3;
-        target_exponents[element.data[2]] *= 2;
-        round_points += target_exponents[element.data[2]];
-        mark_stale(stale_pieces, element.data[3]);
-        should_add_new_piece = true;
-      } else if (exponents[element.data[1]] == exponents[element.data[2]]) {
-        target_slots[element.data[0]] = i + 4;
-        target_slots[element.data[1]] = i + 4 * 2;
-        target_exponents[element.data[1]] *= 2;
-        round_points += target_exponents[element.data[1]];
-        mark_stale(stale_pieces, element.data[2]);
-        should_add_new_piece = true;
-      } else if (exponents[element.data[0]] == exponents[element.data[1]]) {
-        target_slots[element.data[0]] = i + 4;
-        target_exponents[element.data[0]] *= 2;
-        round_points += target_exponents[element.data[0]];
-        mark_stale(stale_pieces, element.data[1]);
-        should_add_new_piece = true;
-      }
-      break;
-
-    default:
-      break;
+  for (surge::u8 slot = 0; slot < max_pieces; slot++) {
+    const auto exponent{board::get_exponent(b, slot)};
+    if (exponent != 0) {
+      create_piece(pd, exponent, slot);
     }
   }
-
-  game_score += round_points;
 }
 
 void s2048::pieces::mark_stale(piece_id_queue_t &stale_pieces, surge::u8 piece) noexcept {
@@ -957,123 +202,68 @@ void s2048::pieces::remove_stale(piece_id_queue_t &stale_pieces, pieces_data &pd
   }
 }
 
-auto s2048::pieces::value_to_texture_handle(const tdb_t &tdb,
-                                            surge::u16 value) noexcept -> GLuint64 {
-  static const auto handle_2{tdb.find("resources/pieces_2.png").value_or(0)};
-  static const auto handle_4{tdb.find("resources/pieces_4.png").value_or(0)};
-  static const auto handle_8{tdb.find("resources/pieces_8.png").value_or(0)};
-  static const auto handle_16{tdb.find("resources/pieces_16.png").value_or(0)};
-  static const auto handle_32{tdb.find("resources/pieces_32.png").value_or(0)};
-  static const auto handle_64{tdb.find("resources/pieces_64.png").value_or(0)};
-  static const auto handle_128{tdb.find("resources/pieces_128.png").value_or(0)};
-  static const auto handle_256{tdb.find("resources/pieces_256.png").value_or(0)};
-  static const auto handle_512{tdb.find("resources/pieces_512.png").value_or(0)};
-  static const auto handle_1024{tdb.find("resources/pieces_1024.png").value_or(0)};
-  static const auto handle_2048{tdb.find("resources/pieces_2048.png").value_or(0)};
-
-  switch (value) {
-  case 2:
-    return handle_2;
-  case 4:
-    return handle_4;
-  case 8:
-    return handle_8;
-  case 16:
-    return handle_16;
-  case 32:
-    return handle_32;
-  case 64:
-    return handle_64;
-  case 128:
-    return handle_128;
-  case 256:
-    return handle_256;
-  case 512:
-    return handle_512;
-  case 1024:
-    return handle_1024;
-  case 2048:
-    return handle_2048;
-  default:
-    return 0;
-  }
-}
-
-void s2048::pieces::add_sprites_to_database(const tdb_t &tdb, sdb_t &sdb,
-                                            pieces_data &pd) noexcept {
-#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::add_sprites_to_database()");
-#endif
-  using namespace surge;
-  using namespace surge::gl_atom;
-
-  for (const auto &pos_elm : pd.positions) {
-    const auto [id, pos] = pos_elm;
-    const auto handle{value_to_texture_handle(tdb, pd.current_values[id])};
-    const auto model{sprite_database::place_sprite(pos, glm::vec2{105.0f}, 0.2f)};
-    gl_atom::sprite_database::add(sdb, handle, model);
-  }
-}
-
-void s2048::pieces::update_positions(pieces_data &pd) noexcept {
+void s2048::pieces::update_positions(pieces_data &pd, float dt) noexcept {
 #if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
   ZoneScopedN("s2048::pieces::update_positions");
 #endif
 
-  using std::abs, std::sqrt;
+  using std::sqrt;
 
-  // These values must be fine tuned together
-  const float v{(globals::slot_delta * 0.125f)}; // Divide by dt
-  constexpr const float threshold{2.5f};
+  // Distance covered by a sliding piece during dt, in slots. Measuring in slots keeps the speed
+  // the same along both axes when the window does not have the reference aspect ratio.
+  const float step{globals::slide_speed * dt};
+  const auto slot_delta{globals::current_layout.slot_delta};
 
   auto &positions{pd.positions};
 
   auto &slots{pd.current_slots};
   auto &target_slots{pd.target_slots};
 
-  for (const auto &s : slots) {
-    auto piece_id{s.first};
-
-    auto src_slot{s.second};
-    auto tgt_slot{target_slots.at(piece_id)};
+  for_each_piece(pd, [&](surge::u8 piece_id) {
+    const auto src_slot{slots[piece_id]};
+    const auto tgt_slot{target_slots[piece_id]};
 
     // Move pieces
     if (tgt_slot != src_slot) {
-      const auto curr_pos{positions.at(piece_id)};
-      const auto tgt_slot_pos{globals::slot_coords[tgt_slot]};
+      const auto curr_pos{positions[piece_id]};
+      const auto tgt_slot_pos{globals::current_layout.slot_coords[tgt_slot]};
 
       const auto delta_r{tgt_slot_pos - curr_pos};
-      const auto delta_r_length{sqrt(glm::dot(delta_r, delta_r))};
-
-      // Stopping condition
-      if (abs(delta_r_length) < threshold) {
-        slots.at(piece_id) = tgt_slot;
-        positions.at(piece_id) = tgt_slot_pos;
+      const auto delta_slots{delta_r / slot_delta};
+      const auto distance{sqrt(glm::dot(delta_slots, delta_slots))};
+
+      // Arrives during this step
+      if (distance <= step) {
+        slots[piece_id] = tgt_slot;
+        positions[piece_id] = tgt_slot_pos;
+
+        // The slot left behind may already belong to a piece that arrived earlier
+        if (pd.slot_ids[src_slot] == piece_id) {
+          pd.slot_ids[src_slot] = no_piece;
+        }
+        pd.slot_ids[tgt_slot] = piece_id;
       } else {
-        const auto n_r{delta_r / delta_r_length};
-        const auto r_next{curr_pos + v * n_r}; // Multiply by dt. dt cancels
-        positions.at(piece_id) = r_next;
+        positions[piece_id] = curr_pos + delta_r * (step / distance);
       }
     }
-  }
+  });
 }
 
-void s2048::pieces::update_exponents(pieces_data &pd) noexcept {
+void s2048::pieces::settle(pieces_data &pd) noexcept {
 #if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("s2048::pieces::update_exponents");
+  ZoneScopedN("s2048::pieces::settle");
 #endif
 
-  auto &values{pd.current_values};
-  auto &target_values{pd.target_values};
-
-  for (const auto &e : values) {
-    auto piece_id{e.first};
+  // Every slide ends within an infinitely long step
+  update_positions(pd, std::numeric_limits<float>::infinity());
+}
 
-    auto src_val{e.second};
-    auto tgt_val{target_values[piece_id]};
+void s2048::pieces::update_exponents(pieces_data &pd) noexcept {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::pieces::update_exponents");
+#endif
 
-    if (src_val != tgt_val) {
-      values[piece_id] = tgt_val;
-    }
-  }
+  for_each_piece(pd, [&](surge::u8 piece_id) {
+    pd.current_exponents[piece_id] = pd.target_exponents[piece_id];
+  });
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include "png_reader.hpp"
+
+#include <png.h>
+
+#include <cstring>
+
+static void copy_error(const png_image &png, s2048::png_reader::image &img) noexcept {
+  img.error = {};
+  std::strncpy(img.error.data(), png.message, img.error.size() - 1);
+}
+
+auto s2048::png_reader::decode(const char *path, image &img) noexcept -> bool {
+  png_image png{};
+  png.version = PNG_IMAGE_VERSION;
+
+  if (png_image_begin_read_from_file(&png, path) == 0) {
+    copy_error(png, img);
+    return false;
+  }
+
+  png.format = PNG_FORMAT_RGBA;
+  img.pixels.resize(PNG_IMAGE_SIZE(png));
+
+  if (png_image_finish_read(&png, nullptr, img.pixels.data(), 0, nullptr) == 0) {
+    copy_error(png, img);
+    png_image_free(&png);
+    return false;
+  }
+
+  img.width = png.width;
+  img.height = png.height;
+  return true;
+}
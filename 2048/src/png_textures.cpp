@@ -0,0 +1,63 @@
+#include "png_textures.hpp"
+
+#include "png_reader.hpp"
+#include "scheduler.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+#  include <tracy/Tracy.hpp>
+#endif
+
+namespace {
+
+enum image_state : surge::u8 { pending, decoded, failed };
+
+struct image {
+  s2048::png_reader::image png{};
+  std::atomic<surge::u8> state{pending};
+};
+
+} // namespace
+
+auto s2048::png_textures::load(packed_textures::texture_set &ts,
+                               std::span<const char *const> paths) noexcept -> bool {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::png_textures::load");
+#endif
+
+  std::vector<image> images(paths.size());
+
+  // Joins on return, after the workers finished every image
+  std::jthread decoder{[&]() {
+    scheduler::parallel_for(paths.size(), scheduler::options{},
+                            [&](surge::u64 index, surge::u32) {
+                              auto &img{images[index]};
+                              const auto ok{png_reader::decode(paths[index], img.png)};
+                              if (!ok) {
+                                log_error("Unable to decode {}: {}", paths[index],
+                                          img.png.error.data());
+                              }
+                              img.state.store(ok ? decoded : failed, std::memory_order_release);
+                              img.state.notify_one();
+                            });
+  }};
+
+  // Uploads from client memory, like the pack, in path order. Each upload overlaps the decoding
+  // of the images after it.
+  bool ok{true};
+  for (surge::usize i = 0; i < paths.size() && ok; i++) {
+    auto &img{images[i]};
+    img.state.wait(pending, std::memory_order_acquire);
+
+    ok = img.state.load(std::memory_order_acquire) == decoded
+         && packed_textures::add(ts, paths[i], img.png.width, img.png.height,
+                                 img.png.pixels.data());
+
+    img.png.pixels = std::vector<std::byte>{};
+  }
+
+  return ok;
+}
@@ -0,0 +1,25 @@
+#include "policy.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr const std::array<const char *, 4> names{"random", "greedy", "corner", "solver"};
+
+} // namespace
+
+auto s2048::policy::parse(const char *name, kind &k) noexcept -> bool {
+  for (surge::usize i = 0; i < names.size(); i++) {
+    if (std::strcmp(name, names[i]) == 0) {
+      k = static_cast<kind>(i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+auto s2048::policy::name(kind k) noexcept -> const char * {
+  return names[static_cast<surge::usize>(k)];
+}
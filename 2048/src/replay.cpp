@@ -0,0 +1,39 @@
+#include "replay.hpp"
+
+#include "grid.hpp"
+
+namespace {
+
+template <surge::u8 N>
+auto run_on(const s2048::save_game::save &s) noexcept -> s2048::replay::result {
+  using namespace s2048;
+
+  replay::result r{};
+
+  const spawner::config cfg{s.two_probability};
+
+  auto g{s.start_rng};
+  auto b{grid::spawn(g, cfg, grid::spawn(g, cfg, grid::grid<N>{}))};
+
+  for (surge::u32 i = 0; i < s.move_count; i++) {
+    const auto moved{grid::move(b, save_game::recorded_move(s, i))};
+    if (!moved.changed) {
+      r.legal = false;
+      break;
+    }
+
+    r.score += moved.score;
+    b = grid::spawn(g, cfg, moved.board);
+    r.moves++;
+  }
+
+  r.board = b.s;
+  r.matches = r.legal && r.board == s.board && r.score == s.score;
+  return r;
+}
+
+} // namespace
+
+auto s2048::replay::run(const save_game::save &s) noexcept -> result {
+  return s.size == 3 ? run_on<3>(s) : run_on<4>(s);
+}
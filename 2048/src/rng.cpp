@@ -0,0 +1,49 @@
+#include "rng.hpp"
+
+namespace {
+
+auto splitmix64(surge::u64 &x) noexcept -> surge::u64 {
+  x += 0x9E3779B97F4A7C15ULL;
+
+  auto z{x};
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+} // namespace
+
+auto s2048::rng::from_seed(surge::u64 seed) noexcept -> generator {
+  generator g{};
+  for (auto &word : g.s) {
+    word = splitmix64(seed);
+  }
+  return g;
+}
+
+auto s2048::rng::stream(surge::u64 seed, surge::u64 index) noexcept -> generator {
+  // The key goes through one splitmix64 round first, so neighbouring indices give unrelated seeds
+  auto key{seed};
+  const auto mixed_seed{splitmix64(key) ^ index};
+  return from_seed(mixed_seed);
+}
+
+void s2048::rng::jump(generator &g) noexcept {
+  constexpr const std::array<surge::u64, 4> polynomial{
+      0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+
+  std::array<surge::u64, 4> s{};
+
+  for (const auto word : polynomial) {
+    for (int b = 0; b < 64; b++) {
+      if ((word & (surge::u64{1} << b)) != 0) {
+        for (surge::usize i = 0; i < s.size(); i++) {
+          s[i] ^= g.s[i];
+        }
+      }
+      next(g);
+    }
+  }
+
+  g.s = s;
+}
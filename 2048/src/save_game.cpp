@@ -0,0 +1,220 @@
+#include "save_game.hpp"
+
+#include "mapped_file.hpp"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+static_assert(std::endian::native == std::endian::little, "Save files are little endian");
+
+namespace {
+
+// Version 1: u32 scores and a minstd_rand state, whose spawns the current generator can not replay
+struct header_v1 {
+  std::array<char, 4> magic;
+  surge::u32 version;
+  s2048::board::board_t board;
+  surge::u32 score;
+  surge::u32 best_score;
+  surge::u32 rng_state;
+  surge::u32 start_rng_state;
+  surge::u32 move_count;
+  surge::u32 reserved;
+};
+
+static_assert(sizeof(header_v1) == 40);
+
+// Version 2: u32 scores and no flags
+struct header_v2 {
+  std::array<char, 4> magic;
+  surge::u32 version;
+  s2048::board::board_t board;
+  surge::u32 score;
+  surge::u32 best_score;
+  surge::u32 move_count;
+  float two_probability;
+  std::array<surge::u64, 4> rng;
+  std::array<surge::u64, 4> start_rng;
+};
+
+static_assert(sizeof(header_v2) == 96);
+
+// Copies the move history that follows a header of header_size bytes
+auto decode_moves(const surge::u8 *data, surge::u64 size, surge::u64 header_size,
+                  surge::u32 move_count, s2048::save_game::save &s) noexcept -> bool {
+  const auto move_bytes{(surge::u64{move_count} + 3) / 4};
+  if (size - header_size < move_bytes) {
+    return false;
+  }
+
+  s.move_count = move_count;
+  s.moves.resize(static_cast<surge::usize>(move_bytes));
+  if (move_bytes != 0) {
+    std::memcpy(s.moves.data(), data + header_size, s.moves.size());
+  }
+
+  return true;
+}
+
+/*
+ * The board, scores and best score carry over. The history can not be replayed, so it is dropped
+ * and the game goes on from a generator seeded with the old state.
+ */
+auto decode_v1(const surge::u8 *data, surge::u64 size, s2048::save_game::save &s) noexcept -> bool {
+  if (size < sizeof(header_v1)) {
+    return false;
+  }
+
+  header_v1 h{};
+  std::memcpy(&h, data, sizeof(header_v1));
+
+  // The history is dropped, but a file too short for it is not a valid save
+  if (size - sizeof(header_v1) < (surge::u64{h.move_count} + 3) / 4) {
+    return false;
+  }
+
+  s = s2048::save_game::save{};
+  s.board = h.board;
+  s.score = h.score;
+  s.best_score = h.best_score;
+  s.rng = s2048::rng::from_seed(h.rng_state);
+  s.start_rng = s.rng;
+  return true;
+}
+
+auto decode_v2(const surge::u8 *data, surge::u64 size, s2048::save_game::save &s) noexcept -> bool {
+  if (size < sizeof(header_v2)) {
+    return false;
+  }
+
+  header_v2 h{};
+  std::memcpy(&h, data, sizeof(header_v2));
+
+  s = s2048::save_game::save{};
+  s.board = h.board;
+  s.score = h.score;
+  s.best_score = h.best_score;
+  s.two_probability = h.two_probability;
+  s.rng.s = h.rng;
+  s.start_rng.s = h.start_rng;
+  return decode_moves(data, size, sizeof(header_v2), h.move_count, s);
+}
+
+} // namespace
+
+void s2048::save_game::record_move(save &s, board::direction d) noexcept {
+  const auto shift{2 * (s.move_count % 4)};
+  if (shift == 0) {
+    s.moves.push_back(0);
+  }
+
+  s.moves.back() = static_cast<surge::u8>(s.moves.back() | (d << shift));
+  s.move_count++;
+}
+
+auto s2048::save_game::recorded_move(const save &s, surge::u32 index) noexcept -> board::direction {
+  return static_cast<board::direction>((s.moves[index / 4] >> (2 * (index % 4))) & 3u);
+}
+
+void s2048::save_game::encode(const save &s, std::vector<surge::u8> &bytes) noexcept {
+  header h{};
+  h.magic = magic;
+  h.version = version;
+  h.board = s.board;
+  h.score = s.score;
+  h.best_score = s.best_score;
+  h.move_count = s.move_count;
+  h.two_probability = s.two_probability;
+  h.flags = s.keep_playing ? keep_playing_flag : 0;
+  h.size = s.size;
+  h.rng = s.rng.s;
+  h.start_rng = s.start_rng.s;
+
+  const auto move_bytes{static_cast<surge::usize>((s.move_count + 3) / 4)};
+
+  bytes.resize(sizeof(header) + move_bytes);
+  std::memcpy(bytes.data(), &h, sizeof(header));
+  if (move_bytes != 0) {
+    std::memcpy(bytes.data() + sizeof(header), s.moves.data(), move_bytes);
+  }
+}
+
+auto s2048::save_game::decode(const surge::u8 *data, surge::u64 size, save &s) noexcept -> bool {
+  // Every version starts with the magic and the version
+  if (size < 8 || std::memcmp(data, magic.data(), magic.size()) != 0) {
+    return false;
+  }
+
+  surge::u32 file_version{0};
+  std::memcpy(&file_version, data + magic.size(), sizeof(file_version));
+
+  if (file_version == 1) {
+    return decode_v1(data, size, s);
+  } else if (file_version == 2) {
+    return decode_v2(data, size, s);
+  } else if (file_version != version || size < sizeof(header)) {
+    return false;
+  }
+
+  header h{};
+  std::memcpy(&h, data, sizeof(header));
+
+  // A 3x3 board leaves the slots past its ninth empty
+  const auto board_size{h.size == 0 ? 4u : h.size};
+  if ((board_size != 3 && board_size != 4) || (board_size == 3 && (h.board >> 36) != 0)) {
+    return false;
+  }
+
+  s = save{};
+  s.board = h.board;
+  s.size = static_cast<surge::u8>(board_size);
+  s.score = h.score;
+  s.best_score = h.best_score;
+  s.two_probability = h.two_probability;
+  s.keep_playing = (h.flags & keep_playing_flag) != 0;
+  s.rng.s = h.rng;
+  s.start_rng.s = h.start_rng;
+  return decode_moves(data, size, sizeof(header), h.move_count, s);
+}
+
+auto s2048::save_game::write(const char *path, const save &s) noexcept -> bool {
+  std::vector<surge::u8> bytes{};
+  encode(s, bytes);
+
+  const std::string tmp_path{std::string{path} + ".tmp"};
+
+  const auto out{std::fopen(tmp_path.c_str(), "wb")};
+  if (out == nullptr) {
+    return false;
+  }
+
+  bool ok{std::fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size()};
+  ok = std::fclose(out) == 0 && ok;
+
+  std::error_code ec{};
+  if (ok) {
+    std::filesystem::rename(tmp_path, path, ec);
+  }
+
+  if (!ok || ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+
+  return true;
+}
+
+auto s2048::save_game::read(const char *path, save &s) noexcept -> bool {
+  mapped_file::mapping m{};
+  if (!mapped_file::open(m, path)) {
+    return false;
+  }
+
+  const auto ok{decode(reinterpret_cast<const surge::u8 *>(m.data), m.size, s)};
+
+  mapped_file::close(m);
+  return ok;
+}
@@ -0,0 +1,132 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#elif defined(_WIN32)
+#  include <windows.h>
+#endif
+
+namespace {
+
+struct alignas(64) index_range {
+  std::mutex lock{};
+  surge::u64 begin{0};
+  surge::u64 end{0};
+};
+
+auto take(index_range &r, surge::u64 &index) noexcept -> bool {
+  std::lock_guard guard{r.lock};
+  if (r.begin < r.end) {
+    index = r.begin;
+    r.begin++;
+    return true;
+  }
+  return false;
+}
+
+auto steal(std::vector<index_range> &ranges, surge::u32 thief) noexcept -> bool {
+  const auto n{static_cast<surge::u32>(ranges.size())};
+
+  for (surge::u32 i = 1; i < n; i++) {
+    auto &victim{ranges[(thief + i) % n]};
+
+    surge::u64 begin{0};
+    surge::u64 end{0};
+
+    {
+      std::lock_guard guard{victim.lock};
+      const auto remaining{victim.end - victim.begin};
+      if (remaining == 0) {
+        continue;
+      }
+
+      // Take the upper half, or the last index if only one is left
+      begin = victim.begin + remaining / 2;
+      end = victim.end;
+      victim.end = begin;
+    }
+
+    std::lock_guard guard{ranges[thief].lock};
+    ranges[thief].begin = begin;
+    ranges[thief].end = end;
+    return true;
+  }
+
+  return false;
+}
+
+void pin_current_thread(surge::u32 worker) noexcept {
+  const auto cpus{std::max(std::thread::hardware_concurrency(), 1u)};
+  const auto cpu{worker % cpus};
+
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+  SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << (cpu % (sizeof(DWORD_PTR) * 8)));
+#else
+  static_cast<void>(cpu);
+#endif
+}
+
+} // namespace
+
+auto s2048::scheduler::worker_count(const options &opts) noexcept -> surge::u32 {
+  if (opts.threads != 0) {
+    return opts.threads;
+  }
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void s2048::scheduler::parallel_for(surge::u64 count, const options &opts, const job_t &job) {
+  const auto workers{worker_count(opts)};
+
+  std::vector<index_range> ranges(workers);
+
+  const auto share{count / workers};
+  const auto extra{count % workers};
+
+  for (surge::u64 w = 0, begin = 0; w < workers; w++) {
+    const auto size{share + (w < extra ? 1 : 0)};
+    ranges[w].begin = begin;
+    ranges[w].end = begin + size;
+    begin += size;
+  }
+
+  const auto work{[&](surge::u32 worker) {
+    if (opts.pin) {
+      pin_current_thread(worker);
+    }
+
+    surge::u64 index{0};
+    while (true) {
+      if (take(ranges[worker], index)) {
+        job(index, worker);
+      } else if (!steal(ranges, worker)) {
+        break;
+      }
+    }
+  }};
+
+  std::vector<std::thread> threads{};
+  threads.reserve(workers - 1);
+
+  for (surge::u32 w = 1; w < workers; w++) {
+    threads.emplace_back(work, w);
+  }
+
+  // The calling thread is worker 0
+  work(0);
+
+  for (auto &t : threads) {
+    t.join();
+  }
+}
@@ -0,0 +1,247 @@
+#include "solver.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+
+// Heuristic weights, tuned for the 2048 expectimax players of the literature
+constexpr const float lost_penalty{200000.0f};
+constexpr const float monotonicity_power{4.0f};
+constexpr const float monotonicity_weight{47.0f};
+constexpr const float sum_power{3.5f};
+constexpr const float sum_weight{11.0f};
+constexpr const float merges_weight{700.0f};
+constexpr const float empty_weight{270.0f};
+
+auto row_heuristic(s2048::board::row_t row) noexcept -> float {
+  std::array<surge::u8, 4> line{};
+  for (surge::u8 i = 0; i < 4; i++) {
+    line[i] = static_cast<surge::u8>((row >> (4 * i)) & 0xF);
+  }
+
+  float sum{0.0f};
+  float empty{0.0f};
+  float merges{0.0f};
+
+  surge::u8 prev{0};
+  surge::u8 counter{0};
+
+  for (const auto rank : line) {
+    sum += std::pow(static_cast<float>(rank), sum_power);
+
+    if (rank == 0) {
+      empty += 1.0f;
+    } else {
+      if (prev == rank) {
+        counter++;
+      } else if (counter > 0) {
+        merges += static_cast<float>(1 + counter);
+        counter = 0;
+      }
+      prev = rank;
+    }
+  }
+
+  if (counter > 0) {
+    merges += static_cast<float>(1 + counter);
+  }
+
+  float monotonicity_left{0.0f};
+  float monotonicity_right{0.0f};
+
+  for (surge::u8 i = 1; i < 4; i++) {
+    const auto a{std::pow(static_cast<float>(line[i - 1]), monotonicity_power)};
+    const auto b{std::pow(static_cast<float>(line[i]), monotonicity_power)};
+
+    if (line[i - 1] > line[i]) {
+      monotonicity_left += a - b;
+    } else {
+      monotonicity_right += b - a;
+    }
+  }
+
+  return lost_penalty + empty_weight * empty + merges_weight * merges
+         - monotonicity_weight * std::min(monotonicity_left, monotonicity_right)
+         - sum_weight * sum;
+}
+
+auto heuristic_table() noexcept -> const std::array<float, 65536> & {
+  static std::array<float, 65536> t{};
+
+  static const bool initialized{[]() {
+    for (surge::u32 i = 0; i < 65536; i++) {
+      t[i] = row_heuristic(static_cast<s2048::board::row_t>(i));
+    }
+    return true;
+  }()};
+
+  static_cast<void>(initialized);
+  return t;
+}
+
+auto tt_index(const s2048::solver::context &ctx, s2048::board::board_t b) noexcept -> surge::u64 {
+  return ((b ^ (b >> 29)) * 0x9E3779B97F4A7C15ULL >> 20) & ctx.table_mask;
+}
+
+auto out_of_time(s2048::solver::context &ctx) noexcept -> bool {
+  if (!ctx.aborted && (ctx.nodes & 0x3FF) == 0) {
+    ctx.aborted = std::chrono::steady_clock::now() >= ctx.deadline;
+  }
+  return ctx.aborted;
+}
+
+auto chance_node(s2048::solver::context &ctx, const s2048::solver::config &cfg,
+                 s2048::board::board_t b, surge::u8 depth, float probability) noexcept -> float;
+
+auto max_node(s2048::solver::context &ctx, const s2048::solver::config &cfg,
+              s2048::board::board_t b, surge::u8 depth, float probability) noexcept -> float {
+  using namespace s2048;
+
+  float best{0.0f};
+
+  for (surge::u8 d = 0; d < 4; d++) {
+    const auto moved{board::move(b, static_cast<board::direction>(d))};
+    if (moved.changed) {
+      best = std::max(best, chance_node(ctx, cfg, moved.board, depth, probability));
+    }
+  }
+
+  return best;
+}
+
+auto chance_node(s2048::solver::context &ctx, const s2048::solver::config &cfg,
+                 s2048::board::board_t b, surge::u8 depth, float probability) noexcept -> float {
+  using namespace s2048;
+
+  ctx.nodes++;
+
+  if (depth == 0 || probability < cfg.probability_cutoff || out_of_time(ctx)) {
+    return solver::heuristic(b);
+  }
+
+  // An entry reached with a lower probability may have been cut off where this search is not
+  auto &entry{ctx.table[tt_index(ctx, b)]};
+  if (entry.board == b && entry.depth >= depth && entry.probability >= probability) {
+    return entry.value;
+  }
+
+  const auto empty{board::empty_mask(b)};
+  const auto empty_count{std::popcount(empty)};
+
+  if (empty_count == 0) {
+    return solver::heuristic(b);
+  }
+
+  const auto p2{cfg.two_probability};
+  const auto p4{1.0f - cfg.two_probability};
+  const auto slot_probability{probability / static_cast<float>(empty_count)};
+  const auto child_depth{static_cast<surge::u8>(depth - 1)};
+
+  float value{0.0f};
+
+  for (auto bits{empty}; bits != 0; bits = static_cast<surge::u16>(bits & (bits - 1))) {
+    const auto slot{static_cast<surge::u8>(std::countr_zero(bits))};
+
+    if (p2 > 0.0f) {
+      value += p2 * max_node(ctx, cfg, board::set_exponent(b, slot, 1), child_depth,
+                             slot_probability * p2);
+    }
+
+    if (p4 > 0.0f) {
+      value += p4 * max_node(ctx, cfg, board::set_exponent(b, slot, 2), child_depth,
+                             slot_probability * p4);
+    }
+  }
+
+  value /= static_cast<float>(empty_count);
+
+  // Values computed after the deadline are incomplete and must not be cached
+  if (!ctx.aborted) {
+    entry = solver::tt_entry{b, value, probability, depth};
+  }
+
+  return value;
+}
+
+} // namespace
+
+auto s2048::solver::create_context(surge::u8 table_bits) noexcept -> context {
+  context ctx{};
+  ctx.table.resize(surge::usize{1} << table_bits);
+  ctx.table_mask = (surge::u64{1} << table_bits) - 1;
+  return ctx;
+}
+
+void s2048::solver::clear(context &ctx) noexcept {
+  std::ranges::fill(ctx.table, tt_entry{});
+  ctx.nodes = 0;
+  ctx.aborted = false;
+}
+
+auto s2048::solver::heuristic(board::board_t b) noexcept -> float {
+  const auto &t{heuristic_table()};
+  const auto tr{board::transpose(b)};
+
+  float h{0.0f};
+  for (surge::u8 i = 0; i < 4; i++) {
+    h += t[static_cast<board::row_t>(b >> (16 * i))];
+    h += t[static_cast<board::row_t>(tr >> (16 * i))];
+  }
+
+  return h;
+}
+
+auto s2048::solver::search(context &ctx, board::board_t b, const config &cfg) noexcept -> result {
+  result res{};
+
+  std::array<board::move_result, 4> moves{};
+  for (surge::u8 d = 0; d < 4; d++) {
+    moves[d] = board::move(b, static_cast<board::direction>(d));
+    res.has_move = res.has_move || moves[d].changed;
+  }
+
+  if (!res.has_move) {
+    return res;
+  }
+
+  ctx.nodes = 0;
+  ctx.aborted = false;
+  ctx.deadline = std::chrono::steady_clock::now() + cfg.budget;
+
+  for (surge::u8 depth = 1; depth <= cfg.max_depth; depth++) {
+    std::array<float, 4> values{0.0f, 0.0f, 0.0f, 0.0f};
+    const auto child_depth{static_cast<surge::u8>(depth - 1)};
+
+    for (surge::u8 d = 0; d < 4; d++) {
+      if (moves[d].changed) {
+        values[d] = chance_node(ctx, cfg, moves[d].board, child_depth, 1.0f);
+      }
+    }
+
+    // The first iteration is always kept, so there is a move to play even with a zero budget
+    if (ctx.aborted && depth > 1) {
+      break;
+    }
+
+    res.values = values;
+    res.depth = depth;
+
+    if (ctx.aborted) {
+      break;
+    }
+  }
+
+  res.nodes = ctx.nodes;
+
+  bool first{true};
+  for (surge::u8 d = 0; d < 4; d++) {
+    if (moves[d].changed && (first || res.values[d] > res.values[res.best])) {
+      res.best = static_cast<board::direction>(d);
+      first = false;
+    }
+  }
+
+  return res;
+}
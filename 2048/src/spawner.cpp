@@ -0,0 +1,64 @@
+#include "spawner.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+struct draw_result {
+  surge::u8 slot;
+  surge::u8 exponent;
+};
+
+auto draw(s2048::rng::generator &g, const s2048::spawner::config &cfg,
+          surge::u16 empty) noexcept -> draw_result {
+  using namespace s2048::spawner;
+
+  const auto exponent{draw_exponent(g, cfg.two_probability)};
+  const auto n{draw_index(g, static_cast<surge::u64>(std::popcount(empty)))};
+
+  return draw_result{s2048::board::select_slot(empty, n), exponent};
+}
+
+// Empty slots among the first side x side of b
+auto empty_slots(s2048::board::board_t b, surge::u8 side) noexcept -> surge::u16 {
+  const auto slots{static_cast<surge::u16>((1u << (side * side)) - 1)};
+  return static_cast<surge::u16>(s2048::board::empty_mask(b) & slots);
+}
+
+} // namespace
+
+auto s2048::spawner::spawn(rng::generator &g, const config &cfg, board::board_t b,
+                           board::track_list &tracks, surge::u8 side) noexcept -> board::board_t {
+  const auto empty{empty_slots(b, side)};
+  if (empty == 0) {
+    return b;
+  }
+
+  const auto d{draw(g, cfg, empty)};
+  return board::spawn(b, d.slot, d.exponent, tracks);
+}
+
+auto s2048::spawner::spawn(rng::generator &g, const config &cfg, board::board_t b,
+                           surge::u8 side) noexcept -> board::board_t {
+  const auto empty{empty_slots(b, side)};
+  if (empty == 0) {
+    return b;
+  }
+
+  const auto d{draw(g, cfg, empty)};
+  return board::set_exponent(b, d.slot, d.exponent);
+}
+
+auto s2048::spawner::draw_exponent(rng::generator &g, float two_probability) noexcept
+    -> surge::u8 {
+  // The probability as a 24 bit threshold, compared against the top 24 bits of a draw
+  const auto p{std::clamp(two_probability, 0.0f, 1.0f)};
+  const auto two_threshold{static_cast<surge::u64>(p * 16777216.0f)};
+  return static_cast<surge::u8>((rng::next(g) >> 40) < two_threshold ? 1 : 2);
+}
+
+auto s2048::spawner::draw_index(rng::generator &g, surge::u64 count) noexcept -> surge::u8 {
+  // Multiply and shift maps the top 32 bits of a draw onto [0, count) without a division
+  return static_cast<surge::u8>(((rng::next(g) >> 32) * count) >> 32);
+}
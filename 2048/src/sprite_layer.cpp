@@ -0,0 +1,64 @@
+#include "sprite_layer.hpp"
+
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+#  include <tracy/Tracy.hpp>
+#endif
+
+namespace {
+
+void add(s2048::sdb_t &sdb, const s2048::sprite_layer::sprite &s) noexcept {
+  using namespace surge::gl_atom;
+
+  const auto model{sprite_database::place_sprite(s.pos, s.scale, s.z)};
+  sprite_database::add(sdb, s.handle, model, glm::vec4{1.0f, 1.0f, 1.0f, s.alpha});
+}
+
+} // namespace
+
+void s2048::sprite_layer::set(layer_data &ld, sprite &s, const sprite &value) noexcept {
+  if (!(s == value)) {
+    s = value;
+    ld.dirty = true;
+  }
+}
+
+void s2048::sprite_layer::update_tiles(layer_data &ld, const pieces::tile_handles_t &handles,
+                                       const pieces::pieces_data &pd) noexcept {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::sprite_layer::update_tiles");
+#endif
+
+  if (ld.visible != pd.occupied) {
+    ld.visible = pd.occupied;
+    ld.dirty = true;
+  }
+
+  const auto tile{pieces::tile_size()};
+
+  pieces::for_each_piece(pd, [&](surge::u8 id) {
+    set(ld, ld.tiles[id],
+        sprite{handles[pd.current_exponents[id]], pd.positions[id], tile, 0.2f, 1.0f});
+  });
+}
+
+auto s2048::sprite_layer::commit(layer_data &ld, sdb_t &sdb) noexcept -> surge::u32 {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::sprite_layer::commit");
+#endif
+
+  if (!ld.dirty) {
+    return 0;
+  }
+
+  surge::gl_atom::sprite_database::begin_add(sdb);
+
+  add(sdb, ld.background);
+  add(sdb, ld.button);
+
+  for (auto bits{ld.visible}; bits != 0; bits = static_cast<surge::u16>(bits & (bits - 1))) {
+    add(sdb, ld.tiles[std::countr_zero(bits)]);
+  }
+
+  ld.dirty = false;
+  return 2 + static_cast<surge::u32>(std::popcount(ld.visible));
+}
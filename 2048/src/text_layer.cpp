@@ -0,0 +1,111 @@
+#include "text_layer.hpp"
+
+#include <charconv>
+#include <cstring>
+
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+#  include <tracy/Tracy.hpp>
+#endif
+
+void s2048::text_layer::set_number(layer_data &ld, number_run &run, surge::u64 value) noexcept {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::text_layer::set_number");
+#endif
+
+  if (run.value == value) {
+    return;
+  }
+
+  // 20 digits hold any u64, so this never truncates
+  auto &digits{run.digits};
+  const auto end{std::to_chars(digits.data(), digits.data() + digits.size() - 1, value)};
+  *end.ptr = '\0';
+
+  run.value = value;
+  ld.dirty = true;
+}
+
+void s2048::text_layer::set_message(layer_data &ld, const char *message,
+                                    const glm::vec2 &window_dims) noexcept {
+  if (ld.message != message || ld.window_dims != window_dims) {
+    ld.message = message;
+    ld.window_dims = window_dims;
+    ld.dirty = true;
+  }
+}
+
+void s2048::text_layer::set_labels(layer_data &ld, const pieces::pieces_data &pd,
+                                   const glm::vec2 &tile_size) noexcept {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::text_layer::set_labels");
+#endif
+
+  std::array<tile_label, pieces::max_pieces> labels{};
+  surge::u8 count{0};
+
+  pieces::for_each_piece(pd, [&](surge::u8 id) {
+    if (pd.current_exponents[id] > pieces::last_face) {
+      labels[count] = tile_label{pd.positions[id], pd.current_exponents[id]};
+      count++;
+    }
+  });
+
+  bool changed{count != ld.label_count || ld.tile_size != tile_size};
+  for (surge::u8 i = 0; !changed && i < count; i++) {
+    changed = labels[i].exponent != ld.labels[i].exponent
+              || labels[i].position != ld.labels[i].position;
+  }
+
+  if (changed) {
+    ld.labels = labels;
+    ld.label_count = count;
+    ld.tile_size = tile_size;
+    ld.dirty = true;
+  }
+}
+
+auto s2048::text_layer::commit(layer_data &ld, txd_t &txd) noexcept -> surge::u32 {
+#if defined(SURGE_BUILD_TYPE_Profile) && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("s2048::text_layer::commit");
+#endif
+
+  if (!ld.dirty) {
+    return 0;
+  }
+
+  txd.txb.reset();
+
+  // Score boxes of the board art, each below its caption
+  const auto box{pieces::to_window(glm::vec2{64.0f, 37.0f})};
+  const auto current_box{pieces::to_window(glm::vec2{358.0f, 58.0f})};
+  const auto best_box{pieces::to_window(glm::vec2{432.0f, 58.0f})};
+
+  txd.txb.push_centered(glm::vec3{current_box[0], current_box[1], 0.2f}, 0.25, box, txd.gc,
+                        ld.current_score.digits.data());
+
+  txd.txb.push_centered(glm::vec3{best_box[0], best_box[1], 0.2f}, 0.25, box, txd.gc,
+                        ld.best_score.digits.data());
+
+  auto glyphs{std::strlen(ld.current_score.digits.data())
+              + std::strlen(ld.best_score.digits.data())};
+
+  for (surge::u8 i = 0; i < ld.label_count; i++) {
+    const auto &label{ld.labels[i]};
+
+    std::array<char, 24> digits{};
+    std::to_chars(digits.data(), digits.data() + digits.size() - 1, 1ull << label.exponent);
+
+    txd.txb.push_centered(glm::vec3{label.position[0], label.position[1] + ld.tile_size[1], 0.3f},
+                          0.25, ld.tile_size, txd.gc, digits.data());
+    glyphs += std::strlen(digits.data());
+  }
+
+  if (ld.message != nullptr) {
+    txd.txb.push_centered(glm::vec3{0.0f, ld.window_dims[1], 0.3f}, 0.25,
+                          glm::vec2{ld.window_dims[0], 500.0f}, txd.gc, ld.message);
+    glyphs += std::strlen(ld.message);
+  }
+
+  ld.dirty = false;
+  return static_cast<surge::u32>(glyphs);
+}
@@ -1,9 +1,9 @@
 #include "ui.hpp"
 
 auto s2048::ui::button(surge::window::window_t w, surge::i32 id, ui_state &state, draw_data &dd,
-                       sdb_t &sdb, const button_skin &bs) noexcept -> bool {
+                       sprite_layer::layer_data &ld, sprite_layer::sprite &s,
+                       const button_skin &bs) noexcept -> bool {
   using namespace surge;
-  using namespace surge::gl_atom;
 
   const glm::vec4 widget_rect{dd.pos[0], dd.pos[1], dd.scale[0], dd.scale[1]};
 
@@ -30,19 +30,14 @@ auto s2048::ui::button(surge::window::window_t w, surge::i32 id, ui_state &state
   }
 
   // Display the up or down skin when the button is held
+  auto handle{bs.handle_release};
   if (id == state.active) {
-    const auto model{sprite_database::place_sprite(dd.pos, dd.scale, dd.z)};
-    gl_atom::sprite_database::add(sdb, bs.handle_press, model,
-                                  glm::vec4{1.0f, 1.0f, 1.0f, dd.alpha});
+    handle = bs.handle_press;
   } else if (id == state.hot) {
-    const auto model{sprite_database::place_sprite(dd.pos, dd.scale, dd.z)};
-    gl_atom::sprite_database::add(sdb, bs.handle_select, model,
-                                  glm::vec4{1.0f, 1.0f, 1.0f, dd.alpha});
-  } else {
-    const auto model{sprite_database::place_sprite(dd.pos, dd.scale, dd.z)};
-    gl_atom::sprite_database::add(sdb, bs.handle_release, model,
-                                  glm::vec4{1.0f, 1.0f, 1.0f, dd.alpha});
+    handle = bs.handle_select;
   }
 
+  sprite_layer::set(ld, s, sprite_layer::sprite{handle, dd.pos, dd.scale, dd.z, dd.alpha});
+
   return bttn_result;
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+// Metrics tail. Follows the frame metrics ring the game publishes (see metrics.hpp) and prints one
+// CSV line per frame, without stopping or slowing the game:
+//   2048_metrics [--follow] FILE
+// Without --follow it prints the frames still in the ring and exits. A follower starts over when
+// the game resets the ring or replaces the file.
+
+#include "mapped_file.hpp"
+#include "metrics.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace {
+
+struct ring {
+  s2048::mapped_file::mapping file{};
+  const s2048::metrics::ring_header *header{nullptr};
+  const s2048::metrics::frame_record *records{nullptr};
+  surge::u64 capacity{0};
+};
+
+auto written(const s2048::metrics::ring_header &h) noexcept -> surge::u64 {
+  return h.written.load(std::memory_order_acquire);
+}
+
+// Index of the oldest record still in the ring
+auto oldest(const ring &r) noexcept -> surge::u64 {
+  const auto end{written(*r.header)};
+  return end > r.capacity ? end - r.capacity : 0;
+}
+
+auto attach(ring &r, const char *path) noexcept -> bool {
+  using namespace s2048;
+
+  r = ring{};
+  if (!mapped_file::open(r.file, path)) {
+    return false;
+  }
+
+  const auto &h{*reinterpret_cast<const metrics::ring_header *>(r.file.data)};
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  const auto size{r.file.size};
+  if (size < sizeof(metrics::ring_header) || h.magic != metrics::magic
+      || h.version != metrics::version || h.record_size != sizeof(metrics::frame_record)
+      || size < sizeof(metrics::ring_header) + surge::u64{h.capacity} * h.record_size
+      || h.capacity == 0) {
+    mapped_file::close(r.file);
+    return false;
+  }
+
+  r.header = &h;
+  r.records =
+      reinterpret_cast<const metrics::frame_record *>(r.file.data + sizeof(metrics::ring_header));
+  r.capacity = h.capacity;
+  return true;
+}
+
+void print(const s2048::metrics::frame_record &r) noexcept {
+  using namespace s2048::metrics;
+
+  std::printf("%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+              static_cast<unsigned long long>(r.frame), static_cast<unsigned long long>(r.time_ns),
+              r.phase_ns[phase::ui], r.phase_ns[phase::logic], r.phase_ns[phase::text],
+              r.phase_ns[phase::sprites], r.phase_ns[phase::frame], r.phase_ns[phase::draw],
+              r.moves, r.move_ns, r.sprites, r.glyphs, r.saves, r.allocations);
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  using namespace s2048;
+
+  bool follow{false};
+  const char *path{nullptr};
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--follow") == 0) {
+      follow = true;
+    } else if (argv[i][0] != '-' && path == nullptr) {
+      path = argv[i];
+    } else {
+      path = nullptr;
+      break;
+    }
+  }
+
+  if (path == nullptr) {
+    std::fprintf(stderr, "Usage: %s [--follow] FILE\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  ring r{};
+  if (!attach(r, path)) {
+    std::fprintf(stderr, "%s is not a metrics ring\n", path);
+    return EXIT_FAILURE;
+  }
+
+  std::printf("frame,time_ns,ui_ns,logic_ns,text_ns,sprites_ns,frame_ns,draw_ns,moves,move_ns,"
+              "sprites,glyphs,saves,allocations\n");
+
+  // Starts with the oldest record still in the ring
+  auto next{oldest(r)};
+
+  while (true) {
+    const auto available{written(*r.header)};
+
+    // The game reset the ring (new version or capacity), so the count starts over
+    if (available < next) {
+      next = oldest(r);
+    }
+
+    for (; next < available; next++) {
+      const auto record{r.records[next % r.capacity]};
+
+      // The fence keeps the copy above from moving past the load of written below, which the
+      // acquire load alone does not. The copy is torn when written moved a whole ring past it.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (written(*r.header) - next >= r.capacity) {
+        continue;
+      }
+
+      print(record);
+    }
+
+    if (!follow) {
+      break;
+    }
+
+    std::fflush(stdout);
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+    // A ring of another capacity is a new file renamed over the one mapped here, which then stops
+    // changing. Its size gives it away.
+    std::error_code ec{};
+    const auto size{std::filesystem::file_size(path, ec)};
+    if (!ec && size != r.file.size) {
+      mapped_file::close(r.file);
+      if (!attach(r, path)) {
+        std::fprintf(stderr, "%s is no longer a metrics ring\n", path);
+        return EXIT_FAILURE;
+      }
+      next = oldest(r);
+    }
+  }
+
+  mapped_file::close(r.file);
+  return EXIT_SUCCESS;
+}
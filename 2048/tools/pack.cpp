@@ -0,0 +1,107 @@
+// Asset baker. Decodes the module textures once, at build time, into a single pack that the game
+// maps and uploads at load time (see asset_pack.hpp):
+//   2048_pack OUTPUT INPUT...
+// Inputs are stored under the path they are given with, so run it from the module directory with
+// the same relative paths the game uses.
+
+#include "asset_pack.hpp"
+#include "png_reader.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct texture {
+  s2048::asset_pack::entry entry{};
+  s2048::png_reader::image image{};
+};
+
+auto align(surge::u64 offset) noexcept -> surge::u64 {
+  constexpr auto a{s2048::asset_pack::data_alignment};
+  return (offset + a - 1) / a * a;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  using namespace s2048;
+
+  if (argc < 3) {
+    std::fprintf(stderr, "Usage: %s OUTPUT INPUT...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<texture> textures(static_cast<surge::usize>(argc - 2));
+
+  // Table of contents, pixel data follows it
+  auto offset{sizeof(asset_pack::header) + textures.size() * sizeof(asset_pack::entry)};
+
+  for (surge::usize i = 0; i < textures.size(); i++) {
+    const auto path{argv[i + 2]};
+    auto &t{textures[i]};
+
+    if (std::strlen(path) >= t.entry.name.size()) {
+      std::fprintf(stderr, "Asset name %s is longer than %zu characters\n", path,
+                   t.entry.name.size() - 1);
+      return EXIT_FAILURE;
+    }
+
+    if (!png_reader::decode(path, t.image)) {
+      std::fprintf(stderr, "Unable to decode %s: %s\n", path, t.image.error.data());
+      return EXIT_FAILURE;
+    }
+
+    t.entry.width = t.image.width;
+    t.entry.height = t.image.height;
+    t.entry.size = t.image.pixels.size();
+
+    std::strncpy(t.entry.name.data(), path, t.entry.name.size() - 1);
+
+    offset = align(offset);
+    t.entry.offset = offset;
+    offset += t.entry.size;
+  }
+
+  const auto out{std::fopen(argv[1], "wb")};
+  if (out == nullptr) {
+    std::fprintf(stderr, "Unable to open %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  asset_pack::header h{};
+  h.magic = asset_pack::magic;
+  h.version = asset_pack::version;
+  h.entry_count = static_cast<surge::u32>(textures.size());
+
+  bool ok{std::fwrite(&h, sizeof(h), 1, out) == 1};
+
+  for (const auto &t : textures) {
+    ok = ok && std::fwrite(&t.entry, sizeof(t.entry), 1, out) == 1;
+  }
+
+  const std::array<std::byte, asset_pack::data_alignment> padding{};
+  auto written{sizeof(asset_pack::header) + textures.size() * sizeof(asset_pack::entry)};
+
+  for (const auto &t : textures) {
+    const auto gap{t.entry.offset - written};
+    ok = ok && std::fwrite(padding.data(), 1, gap, out) == gap;
+    const auto &pixels{t.image.pixels};
+    ok = ok && std::fwrite(pixels.data(), 1, pixels.size(), out) == pixels.size();
+    written = t.entry.offset + t.entry.size;
+  }
+
+  ok = std::fclose(out) == 0 && ok;
+
+  if (!ok) {
+    std::fprintf(stderr, "Unable to write %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  std::fprintf(stderr, "Packed %zu textures into %s (%llu bytes)\n", textures.size(), argv[1],
+               static_cast<unsigned long long>(written));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+// Headless replayer. Plays the recorded games of save files again, through the current engine, and
+// checks that each one ends on the board and score that were saved:
+//   2048_replay [--repeat N] [--threads N] FILE...
+// One CSV line per file: file,moves,score,board,result. --repeat plays every file N times, which is
+// how the throughput of the engine is measured on real games.
+
+#include "replay.hpp"
+#include "save_game.hpp"
+#include "scheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct options {
+  surge::u64 repeat{1};
+  s2048::scheduler::options sched{};
+  std::vector<const char *> files{};
+};
+
+auto parse_options(int argc, char **argv, options &opts) noexcept -> bool {
+  for (int i = 1; i < argc; i++) {
+    const auto arg{argv[i]};
+    const auto has_value{i + 1 < argc};
+
+    if (std::strcmp(arg, "--repeat") == 0 && has_value) {
+      opts.repeat = std::max(std::strtoull(argv[++i], nullptr, 10), 1ULL);
+    } else if (std::strcmp(arg, "--threads") == 0 && has_value) {
+      opts.sched.threads = static_cast<surge::u32>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg[0] != '-') {
+      opts.files.push_back(arg);
+    } else {
+      opts.files.clear();
+      break;
+    }
+  }
+
+  if (opts.files.empty()) {
+    std::fprintf(stderr, "Usage: %s [--repeat N] [--threads N] FILE...\n", argv[0]);
+    return false;
+  }
+
+  return true;
+}
+
+auto result_name(const s2048::replay::result &r) noexcept -> const char * {
+  if (!r.legal) {
+    return "illegal_move";
+  }
+  return r.matches ? "ok" : "mismatch";
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  using namespace s2048;
+
+  options opts{};
+  if (!parse_options(argc, argv, opts)) {
+    return EXIT_FAILURE;
+  }
+
+  board::init();
+
+  std::vector<save_game::save> saves(opts.files.size());
+  for (surge::usize i = 0; i < saves.size(); i++) {
+    if (!save_game::read(opts.files[i], saves[i])) {
+      std::fprintf(stderr, "Unable to read the save file %s\n", opts.files[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<replay::result> results(saves.size());
+  std::atomic<surge::u64> total_moves{0};
+
+  const auto start{std::chrono::steady_clock::now()};
+
+  const auto runs{saves.size() * opts.repeat};
+  scheduler::parallel_for(runs, opts.sched, [&](surge::u64 run, surge::u32) {
+    const auto file{static_cast<surge::usize>(run % saves.size())};
+    const auto result{replay::run(saves[file])};
+
+    if (run < saves.size()) {
+      results[file] = result;
+    }
+    total_moves += result.moves;
+  });
+
+  const auto elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start)};
+
+  std::printf("file,moves,score,board,result\n");
+
+  bool all_match{true};
+  for (surge::usize i = 0; i < results.size(); i++) {
+    const auto &r{results[i]};
+    all_match = all_match && r.matches;
+
+    std::printf("%s,%u,%llu,%016llx,%s\n", opts.files[i], r.moves,
+                static_cast<unsigned long long>(r.score),
+                static_cast<unsigned long long>(r.board), result_name(r));
+  }
+
+  const auto seconds{elapsed.count()};
+  std::fprintf(stderr, "replays:     %llu\n", static_cast<unsigned long long>(runs));
+  std::fprintf(stderr, "threads:     %u\n", scheduler::worker_count(opts.sched));
+  std::fprintf(stderr, "time:        %.3f s\n", seconds);
+  std::fprintf(stderr, "moves/s:     %.1f\n", static_cast<double>(total_moves.load()) / seconds);
+
+  return all_match ? EXIT_SUCCESS : EXIT_FAILURE;
+}
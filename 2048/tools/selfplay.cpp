@@ -0,0 +1,327 @@
+// Headless self-play. Plays independent games with a policy (the expectimax solver by default,
+// or the random, greedy and corner baselines) across every core and streams one CSV line per
+// game: game,score,max_tile,moves,duration_us
+// --size plays 3x3 to 8x8 boards through the grid engine, with every policy but the solver.
+// The summary on stderr (throughput, score percentiles and max tile counts) is what engine
+// versions are compared with, so a run is fully determined by its seed, policy and depth.
+// With --positions, every 16th position played is also written as a packed hexadecimal board, which
+// is how the benchmark corpus in bench/boards.txt is produced.
+
+#include "grid.hpp"
+#include "policy.hpp"
+#include "scheduler.hpp"
+#include "solver.hpp"
+#include "spawner.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct options {
+  surge::u64 games{1000};
+  surge::u64 seed{2048};
+  surge::u8 depth{2};
+  surge::u8 size{4};
+  float two_probability{0.5f};
+  s2048::policy::kind policy{s2048::policy::kind::solver};
+  const char *output{nullptr};
+  const char *positions{nullptr};
+  bool quiet{false};
+  s2048::scheduler::options sched{};
+};
+
+struct game_result {
+  surge::u64 score{0};
+  surge::u8 max_exponent{0};
+  surge::u64 moves{0};
+  std::chrono::nanoseconds duration{0};
+};
+
+auto parse_options(int argc, char **argv, options &opts) noexcept -> bool {
+  for (int i = 1; i < argc; i++) {
+    const auto arg{argv[i]};
+    const auto has_value{i + 1 < argc};
+
+    if (std::strcmp(arg, "--games") == 0 && has_value) {
+      opts.games = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(arg, "--threads") == 0 && has_value) {
+      opts.sched.threads = static_cast<surge::u32>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (std::strcmp(arg, "--seed") == 0 && has_value) {
+      opts.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(arg, "--depth") == 0 && has_value) {
+      opts.depth = static_cast<surge::u8>(std::clamp(std::atoi(argv[++i]), 1, 16));
+    } else if (std::strcmp(arg, "--size") == 0 && has_value) {
+      opts.size = static_cast<surge::u8>(std::atoi(argv[++i]));
+    } else if (std::strcmp(arg, "--two-probability") == 0 && has_value) {
+      opts.two_probability = std::clamp(std::strtof(argv[++i], nullptr), 0.0f, 1.0f);
+    } else if (std::strcmp(arg, "--policy") == 0 && has_value
+               && s2048::policy::parse(argv[i + 1], opts.policy)) {
+      i++;
+    } else if (std::strcmp(arg, "--output") == 0 && has_value) {
+      opts.output = argv[++i];
+    } else if (std::strcmp(arg, "--positions") == 0 && has_value) {
+      opts.positions = argv[++i];
+    } else if (std::strcmp(arg, "--pin") == 0) {
+      opts.sched.pin = true;
+    } else if (std::strcmp(arg, "--quiet") == 0) {
+      opts.quiet = true;
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [--games N] [--threads N] [--seed N] [--depth N] [--size 3-8] "
+                   "[--two-probability P] [--policy random|greedy|corner|solver] "
+                   "[--output FILE] [--positions FILE] [--pin] [--quiet]\n",
+                   argv[0]);
+      return false;
+    }
+  }
+
+  const auto valid_size{opts.size >= 3 && opts.size <= 8};
+  if (!valid_size || (opts.size != 4 && (opts.policy == s2048::policy::kind::solver
+                                         || opts.positions != nullptr))) {
+    std::fprintf(stderr, "Sizes go from 3 to 8, and the solver and --positions need 4\n");
+    return false;
+  }
+
+  return true;
+}
+
+template <surge::u8 N>
+auto play(s2048::policy::player &p, const s2048::spawner::config &spawn_cfg,
+          s2048::rng::generator &g, std::string *positions) noexcept -> game_result {
+  using namespace s2048;
+
+  const auto start{std::chrono::steady_clock::now()};
+
+  game_result result{};
+  auto b{grid::spawn(g, spawn_cfg, grid::spawn(g, spawn_cfg, grid::grid<N>{}))};
+
+  while (true) {
+    const auto decision{policy::choose(p, b)};
+    if (!decision.has_move) {
+      break;
+    }
+
+    if constexpr (N == 4) {
+      if (positions != nullptr && result.moves % 16 == 0) {
+        std::array<char, 32> line{};
+        const auto size{std::snprintf(line.data(), line.size(), "%016llx\n",
+                                      static_cast<unsigned long long>(b.s))};
+        positions->append(line.data(), static_cast<surge::usize>(size));
+      }
+    }
+
+    const auto moved{grid::move(b, decision.move)};
+    result.score += moved.score;
+    result.moves++;
+
+    b = grid::spawn(g, spawn_cfg, moved.board);
+  }
+
+  result.max_exponent = grid::max_exponent(b);
+
+  result.duration = std::chrono::steady_clock::now() - start;
+  return result;
+}
+
+auto play_size(surge::u8 size, s2048::policy::player &p, const s2048::spawner::config &spawn_cfg,
+               s2048::rng::generator &g, std::string *positions) noexcept -> game_result {
+  switch (size) {
+  case 3:
+    return play<3>(p, spawn_cfg, g, positions);
+  case 5:
+    return play<5>(p, spawn_cfg, g, positions);
+  case 6:
+    return play<6>(p, spawn_cfg, g, positions);
+  case 7:
+    return play<7>(p, spawn_cfg, g, positions);
+  case 8:
+    return play<8>(p, spawn_cfg, g, positions);
+  case 4:
+  default:
+    return play<4>(p, spawn_cfg, g, positions);
+  }
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  using namespace s2048;
+
+  options opts{};
+  if (!parse_options(argc, argv, opts)) {
+    return EXIT_FAILURE;
+  }
+
+  auto out{stdout};
+  if (opts.output != nullptr) {
+    out = std::fopen(opts.output, "w");
+    if (out == nullptr) {
+      std::fprintf(stderr, "Unable to open %s\n", opts.output);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::FILE *positions_out{nullptr};
+  if (opts.positions != nullptr) {
+    positions_out = std::fopen(opts.positions, "w");
+    if (positions_out == nullptr) {
+      std::fprintf(stderr, "Unable to open %s\n", opts.positions);
+      return EXIT_FAILURE;
+    }
+  }
+
+  board::init();
+
+  const auto workers{scheduler::worker_count(opts.sched)};
+
+  // Fixed depth search, so results only depend on the seed
+  solver::config cfg{};
+  cfg.budget = std::chrono::hours{24};
+  cfg.max_depth = opts.depth;
+  cfg.two_probability = opts.two_probability;
+
+  const spawner::config spawn_cfg{opts.two_probability};
+
+  std::vector<policy::player> players(workers);
+  std::vector<std::string> lines(workers);
+  std::vector<std::string> positions(workers);
+  for (auto &p : players) {
+    p.policy = opts.policy;
+    p.cfg = cfg;
+
+    // Only the solver uses a transposition table
+    if (opts.policy == policy::kind::solver) {
+      p.ctx = solver::create_context(18);
+    }
+  }
+
+  // Written once per game at its own index, so the workers never share an element
+  std::vector<surge::u64> scores(opts.games);
+  std::array<std::atomic<surge::u64>, 32> max_tiles{};
+
+  std::mutex out_lock{};
+  std::atomic<surge::u64> total_moves{0};
+  std::atomic<surge::u64> total_score{0};
+  std::atomic<surge::u8> best_exponent{0};
+
+  const auto flush{[&](surge::u32 worker) {
+    std::lock_guard guard{out_lock};
+    std::fwrite(lines[worker].data(), 1, lines[worker].size(), out);
+    lines[worker].clear();
+
+    if (positions_out != nullptr) {
+      std::fwrite(positions[worker].data(), 1, positions[worker].size(), positions_out);
+      positions[worker].clear();
+    }
+  }};
+
+  if (!opts.quiet) {
+    std::fprintf(out, "game,score,max_tile,moves,duration_us\n");
+  }
+
+  const auto start{std::chrono::steady_clock::now()};
+
+  scheduler::parallel_for(opts.games, opts.sched, [&](surge::u64 game, surge::u32 worker) {
+    // Each game owns its random stream, independently of the worker that plays it
+    auto g{rng::stream(opts.seed, game)};
+
+    // The policy draws from a jumped copy, which never overlaps the spawns
+    auto &p{players[worker]};
+    p.rng = g;
+    rng::jump(p.rng);
+
+    // A table kept from the previous games of this worker would change the searches, and with
+    // them the moves, depending on how the games were spread over the threads
+    if (opts.policy == policy::kind::solver) {
+      solver::clear(p.ctx);
+    }
+
+    const auto result{play_size(opts.size, p, spawn_cfg, g,
+                                positions_out != nullptr ? &positions[worker] : nullptr)};
+
+    total_moves += result.moves;
+    total_score += result.score;
+    scores[game] = result.score;
+    max_tiles[result.max_exponent]++;
+
+    auto best{best_exponent.load()};
+    while (result.max_exponent > best
+           && !best_exponent.compare_exchange_weak(best, result.max_exponent)) {
+    }
+
+    if (!opts.quiet) {
+      std::array<char, 128> line{};
+      const auto us{std::chrono::duration_cast<std::chrono::microseconds>(result.duration)};
+      const auto size{std::snprintf(line.data(), line.size(), "%llu,%llu,%u,%llu,%lld\n",
+                                    static_cast<unsigned long long>(game),
+                                    static_cast<unsigned long long>(result.score),
+                                    1u << result.max_exponent,
+                                    static_cast<unsigned long long>(result.moves),
+                                    static_cast<long long>(us.count()))};
+      lines[worker].append(line.data(), static_cast<surge::usize>(size));
+    }
+
+    if (lines[worker].size() > 4096 || positions[worker].size() > 4096) {
+      flush(worker);
+    }
+  });
+
+  const auto elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now() - start)};
+
+  for (surge::u32 w = 0; w < workers; w++) {
+    flush(w);
+  }
+
+  if (out != stdout) {
+    std::fclose(out);
+  }
+
+  if (positions_out != nullptr) {
+    std::fclose(positions_out);
+  }
+
+  const auto games{static_cast<double>(opts.games)};
+  const auto seconds{elapsed.count()};
+
+  std::fprintf(stderr, "policy:      %s\n", policy::name(opts.policy));
+  std::fprintf(stderr, "board:       %ux%u\n", opts.size, opts.size);
+  std::fprintf(stderr, "games:       %llu\n", static_cast<unsigned long long>(opts.games));
+  std::fprintf(stderr, "threads:     %u\n", workers);
+  std::fprintf(stderr, "time:        %.3f s\n", seconds);
+  std::fprintf(stderr, "games/s:     %.1f\n", games / seconds);
+  std::fprintf(stderr, "moves/s:     %.1f\n", static_cast<double>(total_moves.load()) / seconds);
+  std::fprintf(stderr, "mean score:  %.1f\n",
+               games > 0 ? static_cast<double>(total_score.load()) / games : 0.0);
+  std::fprintf(stderr, "best tile:   %u\n", 1u << best_exponent.load());
+
+  if (opts.games != 0) {
+    std::ranges::sort(scores);
+
+    const auto percentile{[&](surge::u64 pct) {
+      return static_cast<unsigned long long>(scores[(opts.games - 1) * pct / 100]);
+    }};
+
+    std::fprintf(stderr, "score p0/10/50/90/100: %llu %llu %llu %llu %llu\n", percentile(0),
+                 percentile(10), percentile(50), percentile(90), percentile(100));
+
+    std::fprintf(stderr, "max tile    games    share\n");
+    for (surge::u32 e = 0; e < max_tiles.size(); e++) {
+      const auto count{max_tiles[e].load()};
+      if (count != 0) {
+        std::fprintf(stderr, "%8u %8llu %7.2f%%\n", 1u << e, static_cast<unsigned long long>(count),
+                     100.0 * static_cast<double>(count) / games);
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}